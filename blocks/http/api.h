@@ -45,6 +45,7 @@ SOFTWARE.
 
 #if defined(CURRENT_POSIX) || defined(CURRENT_WINDOWS) || defined(CURRENT_APPLE_HTTP_CLIENT_POSIX)
 #include "impl/posix_client.h"
+#include "impl/posix_async_client.h"
 #include "impl/posix_server.h"
 #include "chunked_response_parser.h"
 using HTTP_CLIENT = current::http::HTTPClientPOSIX;
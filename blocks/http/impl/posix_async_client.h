@@ -0,0 +1,529 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2026 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// The asynchronous HTTP client, for the fan-out workloads. The requests are sent and their responses are read
+// over non-blocking sockets, all from the single thread of the `Reactor`, so that many thousands of them
+// can be in flight at once. Linux only.
+//
+//   current::http::HTTPAsyncClientPOSIX client;
+//   std::future<current::http::HTTPResponseWithBuffer> response = client(GET(url));
+//   client(POST(url, body), [](HTTPResponseWithBuffer response) { ... }, [](std::exception_ptr error) { ... });
+//
+// The requests are the very `GET`, `POST`, etc. of `HTTP()`. At most `max_connections_per_host` of them are in flight
+// to each host and port at a time, the rest are queued. A request fails with `HTTPTimeoutException` unless its response
+// has arrived within the timeout, counted from the moment it was submitted. The connections are shared with the
+// blocking client via `HTTPClientConnectionPool()`. The redirects are not followed, the 3xx responses are returned.
+// The callbacks are run on the thread of the reactor, so they should be quick, and must not throw.
+
+#ifndef BLOCKS_HTTP_IMPL_POSIX_ASYNC_CLIENT_H
+#define BLOCKS_HTTP_IMPL_POSIX_ASYNC_CLIENT_H
+
+#include "../../../port.h"
+
+#ifdef CURRENT_POSIX
+
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <strings.h>
+
+#include "posix_client.h"
+
+namespace current {
+namespace http {
+
+namespace impl {
+
+// Parses the HTTP response as its bytes come in. Unlike `GenericHTTPRequestData`, it never reads from the socket.
+class IncrementalHTTPResponseParser final {
+ public:
+  explicit IncrementalHTTPResponseParser(bool head_request) : head_request_(head_request) {}
+
+  // Returns `true` once the response is complete.
+  bool Feed(const char* data, size_t size) {
+    received_anything_ = true;
+    buffer_.append(data, size);
+    while (state_ != State::Done) {
+      if (state_ == State::Head) {
+        const size_t end = buffer_.find("\r\n\r\n");
+        if (end == std::string::npos) {
+          return false;
+        }
+        ParseHead(end + 2u);
+        buffer_.erase(0u, end + 4u);
+      } else if (state_ == State::Body || state_ == State::ChunkData) {
+        const size_t length = std::min(remaining_, buffer_.length());
+        if (!length) {
+          return false;
+        }
+        response_.body.append(buffer_, 0u, length);
+        buffer_.erase(0u, length);
+        remaining_ -= length;
+        if (!remaining_) {
+          state_ = (state_ == State::Body) ? State::Done : State::ChunkEnd;
+        }
+      } else if (state_ == State::UntilClose) {
+        response_.body.append(buffer_);
+        buffer_.clear();
+        return false;
+      } else {
+        // `ChunkSize`, `ChunkEnd`, and `Trailers` are all about one line.
+        const size_t end = buffer_.find("\r\n");
+        if (end == std::string::npos) {
+          return false;
+        }
+        const std::string line = buffer_.substr(0u, end);
+        buffer_.erase(0u, end + 2u);
+        if (state_ == State::ChunkSize) {
+          char* parsed_end;
+          remaining_ = static_cast<size_t>(std::strtoull(line.c_str(), &parsed_end, 16));
+          if (parsed_end == line.c_str() || (*parsed_end && *parsed_end != ';' && *parsed_end != ' ')) {
+            CURRENT_THROW(current::net::ChunkSizeNotAValidHEXValue());
+          }
+          state_ = remaining_ ? State::ChunkData : State::Trailers;
+        } else if (state_ == State::ChunkEnd) {
+          state_ = State::ChunkSize;
+        } else if (line.empty()) {
+          state_ = State::Done;
+        }
+      }
+    }
+    return true;
+  }
+
+  // Returns `true` if the response is complete as the server closes the connection.
+  bool OnEndOfStream() {
+    if (state_ == State::UntilClose) {
+      state_ = State::Done;
+    }
+    return state_ == State::Done;
+  }
+
+  bool ReceivedAnything() const { return received_anything_; }
+
+  // Whether the connection can be used for another request, the way the blocking client decides it.
+  bool ConnectionReusable() const { return keep_alive_ && delimited_by_length_ && buffer_.empty(); }
+
+  HTTPResponseWithBuffer& Response() { return response_; }
+
+ private:
+  enum class State { Head, Body, ChunkSize, ChunkData, ChunkEnd, Trailers, UntilClose, Done };
+
+  static bool EqualsIgnoringCase(const std::string& lhs, const char* rhs) {
+    return ::strcasecmp(lhs.c_str(), rhs) == 0;
+  }
+
+  void ParseHead(size_t length) {
+    size_t begin = 0u;
+    bool first_line = true;
+    bool chunked = false;
+    bool has_length = false;
+    while (begin < length) {
+      const size_t end = buffer_.find("\r\n", begin);
+      const std::string line = buffer_.substr(begin, end - begin);
+      begin = end + 2u;
+      if (first_line) {
+        // `HTTP/1.1 200 OK`.
+        first_line = false;
+        const size_t space = line.find(' ');
+        if (space == std::string::npos) {
+          CURRENT_THROW(current::net::HTTPException("Malformed HTTP response status line: `" + line + "`."));
+        }
+        keep_alive_ = (line.substr(0u, space) == "HTTP/1.1");
+        response_.code = HTTPResponseCode(std::atoi(line.c_str() + space + 1u));
+        continue;
+      }
+      const size_t colon = line.find(':');
+      if (colon == std::string::npos) {
+        continue;
+      }
+      const std::string key = line.substr(0u, colon);
+      const size_t value_begin = line.find_first_not_of(' ', colon + 1u);
+      const std::string value = (value_begin == std::string::npos) ? "" : line.substr(value_begin);
+      response_.headers.SetHeaderOrCookie(key, value);
+      if (EqualsIgnoringCase(key, current::net::constants::kContentLengthHeaderKey)) {
+        has_length = true;
+        remaining_ = static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 10));
+      } else if (EqualsIgnoringCase(key, current::net::constants::kTransferEncodingHeaderKey)) {
+        chunked = EqualsIgnoringCase(value, current::net::constants::kTransferEncodingChunkedValue);
+      } else if (EqualsIgnoringCase(key, current::net::constants::kConnectionHeaderKey)) {
+        keep_alive_ = EqualsIgnoringCase(value, current::net::constants::kConnectionKeepAliveValue);
+      }
+    }
+    const int code = static_cast<int>(response_.code);
+    if (head_request_ || (code >= 100 && code < 200) || code == 204 || code == 304) {
+      delimited_by_length_ = true;
+      state_ = State::Done;
+    } else if (chunked) {
+      state_ = State::ChunkSize;
+    } else if (has_length) {
+      delimited_by_length_ = true;
+      state_ = remaining_ ? State::Body : State::Done;
+    } else {
+      state_ = State::UntilClose;
+    }
+  }
+
+  const bool head_request_;
+  State state_ = State::Head;
+  std::string buffer_;
+  size_t remaining_ = 0u;
+  bool received_anything_ = false;
+  bool keep_alive_ = false;
+  bool delimited_by_length_ = false;
+  HTTPResponseWithBuffer response_;
+};
+
+}  // namespace impl
+
+class HTTPAsyncClientPOSIX final {
+ public:
+  constexpr static size_t kDefaultMaxConnectionsPerHost = 64u;
+  constexpr static std::chrono::milliseconds kDefaultTimeout = std::chrono::milliseconds(10000);
+
+  explicit HTTPAsyncClientPOSIX(size_t max_connections_per_host = kDefaultMaxConnectionsPerHost,
+                                current::net::Reactor& reactor = current::net::DefaultReactor())
+      : state_(std::make_shared<State>(reactor, max_connections_per_host)) {}
+
+  // Submits the request, and returns the future of its response.
+  // The future throws `HTTPTimeoutException`, or the exception the request has failed with.
+  template <class REQUEST>
+  std::future<HTTPResponseWithBuffer> operator()(const REQUEST& request,
+                                                 std::chrono::milliseconds timeout = kDefaultTimeout) {
+    auto promise = std::make_shared<std::promise<HTTPResponseWithBuffer>>();
+    std::future<HTTPResponseWithBuffer> result = promise->get_future();
+    operator()(
+        request,
+        [promise](HTTPResponseWithBuffer response) { promise->set_value(std::move(response)); },
+        [promise](std::exception_ptr error) { promise->set_exception(error); },
+        timeout);
+    return result;
+  }
+
+  // Submits the request, to call either `on_response` or `on_error` once it is done.
+  template <class REQUEST>
+  void operator()(const REQUEST& request,
+                  std::function<void(HTTPResponseWithBuffer)> on_response,
+                  std::function<void(std::exception_ptr)> on_error,
+                  std::chrono::milliseconds timeout = kDefaultTimeout) {
+    auto call = std::make_shared<Call>();
+    call->deadline = std::chrono::steady_clock::now() + timeout;
+    call->on_response = std::move(on_response);
+    call->on_error = std::move(on_error);
+    try {
+      // The blocking client is what knows how to put the request together.
+      HTTPClientPOSIX description{impl::HTTPRedirectHelper::ConstructionParams()};
+      ImplWrapper<HTTPClientPOSIX>::PrepareInput(request, description);
+      const URL parsed_url(description.request_url_);
+      call->host = parsed_url.host;
+      call->port = HTTPClientPOSIX::PortToConnectTo(parsed_url);
+      call->method = description.request_method_;
+      call->url = description.request_url_;
+      call->pooled = description.keep_alive_ && call->method != "HEAD";
+      call->request = description.RequestHead(parsed_url) + description.request_body_contents_;
+      // Resolved here, on the thread submitting the request, as the reactor thread must not block.
+      call->address = state_->Resolve(call->host, call->port);
+    } catch (const current::Exception&) {
+      call->on_error(std::current_exception());
+      return;
+    }
+    state_->Submit(std::move(call));
+  }
+
+  // The number of requests sent and not yet answered.
+  size_t InFlight() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->in_flight;
+  }
+
+  // The number of requests waiting for the other requests to the same host to complete.
+  size_t Queued() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->queued;
+  }
+
+ private:
+  struct Call final {
+    std::string host;
+    int port;
+    sockaddr_in address;
+    std::string method;
+    std::string url;
+    bool pooled;
+    std::string request;
+    std::chrono::steady_clock::time_point deadline;
+    std::function<void(HTTPResponseWithBuffer)> on_response;
+    std::function<void(std::exception_ptr)> on_error;
+
+    // Only touched by the thread of the reactor once the call has started.
+    std::unique_ptr<current::net::Connection> connection;
+    bool connecting = false;
+    bool reused = false;
+    size_t sent = 0u;
+    std::unique_ptr<impl::IncrementalHTTPResponseParser> parser;
+
+    // Guarded by the mutex of the client.
+    bool queued = false;
+    uint64_t queue_timer = 0u;
+
+    bool Repeatable() const { return method != "POST" && method != "PATCH"; }
+  };
+
+  // Shared with the callbacks of the calls in flight, so that they can complete after the client is gone.
+  struct State final : std::enable_shared_from_this<State> {
+    struct Host final {
+      size_t active = 0u;
+      std::deque<std::shared_ptr<Call>> queue;
+    };
+
+    State(current::net::Reactor& reactor, size_t max_connections_per_host)
+        : reactor(reactor), max_connections_per_host(max_connections_per_host) {}
+
+    void Submit(std::shared_ptr<Call> call) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        Host& host = hosts[std::make_pair(call->host, call->port)];
+        if (host.active >= max_connections_per_host) {
+          // The queued call times out right where it is, to be skipped once its turn comes.
+          const auto self = shared_from_this();
+          call->queued = true;
+          ++queued;
+          call->queue_timer = reactor.SetTimer(
+              std::chrono::duration_cast<std::chrono::milliseconds>(call->deadline - std::chrono::steady_clock::now()),
+              [self, call]() { self->OnQueueTimeout(call); });
+          host.queue.push_back(std::move(call));
+          return;
+        }
+        ++host.active;
+        ++in_flight;
+      }
+      Start(std::move(call));
+    }
+
+    void OnQueueTimeout(const std::shared_ptr<Call>& call) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!call->queued) {
+          return;
+        }
+        call->queued = false;
+        --queued;
+      }
+      call->on_error(TimeoutError(*call));
+    }
+
+    void Start(std::shared_ptr<Call> call) {
+      const auto now = std::chrono::steady_clock::now();
+      if (now >= call->deadline) {
+        Fail(call, TimeoutError(*call));
+        return;
+      }
+      try {
+        call->connection = call->pooled ? HTTPClientConnectionPool().Take(call->host, call->port) : nullptr;
+        call->reused = static_cast<bool>(call->connection);
+        call->connecting = !call->reused;
+        if (!call->connection) {
+          call->connection = current::net::ConnectWithoutBlocking(call->address);
+        }
+        call->sent = 0u;
+        call->parser = std::make_unique<impl::IncrementalHTTPResponseParser>(call->method == "HEAD");
+        const auto self = shared_from_this();
+        reactor.Watch(
+            call->connection->socket,
+            EPOLLIN | EPOLLOUT | EPOLLRDHUP,
+            std::chrono::duration_cast<std::chrono::milliseconds>(call->deadline - now) + std::chrono::milliseconds(1),
+            [self, call](uint64_t id, uint32_t events) { self->OnEvent(call, id, events); },
+            [self, call]() { self->Fail(call, TimeoutError(*call)); });
+      } catch (const current::Exception&) {
+        Fail(call, std::current_exception());
+      }
+    }
+
+    void OnEvent(const std::shared_ptr<Call>& call, uint64_t id, uint32_t events) {
+      try {
+        const SOCKET fd = call->connection->socket;
+        if (call->connecting) {
+          if (!(events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+            return;
+          }
+          int error = 0;
+          socklen_t error_length = sizeof(error);
+          if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &error_length) || error) {
+            CURRENT_THROW(current::net::SocketConnectException());
+          }
+          call->connecting = false;
+        }
+        while (call->sent < call->request.length()) {
+          const ssize_t sent = ::send(fd,
+                                      call->request.data() + call->sent,
+                                      call->request.length() - call->sent,
+                                      MSG_NOSIGNAL | MSG_DONTWAIT);
+          if (sent > 0) {
+            call->sent += static_cast<size_t>(sent);
+          } else if (sent < 0 && errno == EINTR) {
+            continue;
+          } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+          } else {
+            CURRENT_THROW(current::net::SocketWriteException());
+          }
+        }
+        char buffer[16 * 1024];
+        while (true) {
+          const ssize_t received = ::recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+          if (received > 0) {
+            if (call->parser->Feed(buffer, static_cast<size_t>(received))) {
+              Complete(call, id);
+              return;
+            }
+          } else if (received == 0) {
+            if (call->parser->OnEndOfStream()) {
+              call->pooled = false;
+              Complete(call, id);
+              return;
+            }
+            CURRENT_THROW(current::net::ConnectionResetByPeer());
+          } else if (errno == EINTR) {
+            continue;
+          } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return;
+          } else {
+            CURRENT_THROW(current::net::SocketReadException());
+          }
+        }
+      } catch (const current::Exception&) {
+        reactor.Unwatch(id);
+        call->connection = nullptr;
+        if (call->reused && !call->parser->ReceivedAnything() && call->Repeatable()) {
+          // The server may have closed the idle connection just as it was taken out of the pool.
+          // Repeat the request over a new connection, as the blocking client does.
+          call->pooled = false;
+          Start(call);
+        } else {
+          Fail(call, std::current_exception());
+        }
+      }
+    }
+
+    void Complete(const std::shared_ptr<Call>& call, uint64_t id) {
+      reactor.Unwatch(id);
+      HTTPResponseWithBuffer& response = call->parser->Response();
+      response.url = call->url;
+      if (call->pooled && call->parser->ConnectionReusable()) {
+        try {
+          current::net::SetBlocking(call->connection->socket, true);
+          HTTPClientConnectionPool().Return(call->host, call->port, std::move(call->connection));
+        } catch (const current::Exception&) {  // LCOV_EXCL_LINE
+        }
+      }
+      call->connection = nullptr;
+      HTTPResponseWithBuffer result = std::move(response);
+      call->parser = nullptr;
+      Release(call);
+      call->on_response(std::move(result));
+    }
+
+    static std::exception_ptr TimeoutError(const Call& call) {
+      return std::make_exception_ptr(current::net::HTTPTimeoutException(call.url));
+    }
+
+    void Fail(const std::shared_ptr<Call>& call, std::exception_ptr error) {
+      call->connection = nullptr;
+      Release(call);
+      call->on_error(error);
+    }
+
+    // Passes the slot of the completed call on to the next one queued for the same host, if any.
+    void Release(const std::shared_ptr<Call>& call) {
+      std::shared_ptr<Call> next;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = hosts.find(std::make_pair(call->host, call->port));
+        Host& host = it->second;
+        while (!host.queue.empty() && !next) {
+          if (host.queue.front()->queued) {
+            next = std::move(host.queue.front());
+            next->queued = false;
+            --queued;
+          }
+          host.queue.pop_front();
+        }
+        if (!next) {
+          --in_flight;
+          if (!--host.active) {
+            hosts.erase(it);
+          }
+        }
+      }
+      if (next) {
+        reactor.Unwatch(next->queue_timer);
+        Start(std::move(next));
+      }
+    }
+
+    // The addresses are resolved once per host and port, as resolving them is the one step that blocks.
+    // The lookup itself is done outside the mutex, so that it holds back no other requests.
+    sockaddr_in Resolve(const std::string& host, int port) {
+      const auto key = std::make_pair(host, port);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto cit = addresses.find(key);
+        if (cit != addresses.end()) {
+          return cit->second;
+        }
+      }
+      const auto addr_info = current::net::GetAddrInfo(host, std::to_string(port));
+      const sockaddr_in address = *reinterpret_cast<const sockaddr_in*>(addr_info->ai_addr);
+      std::lock_guard<std::mutex> lock(mutex);
+      addresses.emplace(key, address);
+      return address;
+    }
+
+    current::net::Reactor& reactor;
+    const size_t max_connections_per_host;
+    mutable std::mutex mutex;
+    std::map<std::pair<std::string, int>, Host> hosts;
+    std::map<std::pair<std::string, int>, sockaddr_in> addresses;
+    size_t in_flight = 0u;
+    size_t queued = 0u;
+  };
+
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace http
+}  // namespace current
+
+#endif  // CURRENT_POSIX
+
+#endif  // BLOCKS_HTTP_IMPL_POSIX_ASYNC_CLIENT_H
@@ -30,7 +30,11 @@ SOFTWARE.
 
 #include "../types.h"
 
+#include <chrono>
+#include <deque>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <set>
 
@@ -38,6 +42,7 @@ SOFTWARE.
 
 #include "../../../bricks/net/http/http.h"
 #include "../../../bricks/file/file.h"
+#include "../../../bricks/util/singleton.h"
 
 namespace current {
 namespace http {
@@ -59,6 +64,103 @@ struct HTTPRedirectHelper : current::net::HTTPDefaultHelper {
 };
 }  // namespace impl
 
+// The connections of the POSIX HTTP client kept open between the requests, per host and port.
+// A connection goes back to the pool once the response has been read, if the server is fine with keeping it open,
+// and the response is delimited by `Content-Length`. Chunked responses are not pooled, as in Current they are
+// streams, with the server closing the connection once done. At most `max_idle_per_host` connections per host
+// are kept, each for at most `idle_timeout`, and a connection taken out of the pool is first checked
+// to not have been closed by the server while it was idle.
+// Use `HTTPClientConnectionPool().Disable()` to opt out for the whole binary, or `.KeepAlive(false)` per request.
+class HTTPClientPOSIXConnectionPool final {
+ public:
+  constexpr static size_t kDefaultMaxIdlePerHost = 8u;
+  constexpr static std::chrono::milliseconds kDefaultIdleTimeout = std::chrono::milliseconds(5000);
+
+  void SetLimits(size_t max_idle_per_host, std::chrono::milliseconds idle_timeout) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_idle_per_host_ = max_idle_per_host;
+    idle_timeout_ = idle_timeout;
+    for (auto& host : idle_) {
+      while (host.second.size() > max_idle_per_host_) {
+        host.second.pop_front();
+      }
+    }
+  }
+  void Disable() { SetLimits(0u, std::chrono::milliseconds(0)); }
+
+  bool Enabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return max_idle_per_host_ && idle_timeout_.count();
+  }
+
+  size_t IdleConnections() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t result = 0u;
+    for (const auto& host : idle_) {
+      result += host.second.size();
+    }
+    return result;
+  }
+
+  // Returns the most recently used healthy connection to `host:port`, or `nullptr` if there is none.
+  std::unique_ptr<current::net::Connection> Take(const std::string& host, int port) {
+    while (true) {
+      std::unique_ptr<current::net::Connection> connection = [&]() -> std::unique_ptr<current::net::Connection> {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto it = idle_.find(std::make_pair(host, port));
+        if (it == idle_.end()) {
+          return nullptr;
+        }
+        const auto give_up = std::chrono::steady_clock::now() - idle_timeout_;
+        while (!it->second.empty() && it->second.front().since < give_up) {
+          it->second.pop_front();
+        }
+        if (it->second.empty()) {
+          idle_.erase(it);
+          return nullptr;
+        }
+        std::unique_ptr<current::net::Connection> result = std::move(it->second.back().connection);
+        it->second.pop_back();
+        return result;
+      }();
+      if (!connection) {
+        return nullptr;
+      }
+      // An idle connection has nothing to read but the server closing it, or its remains from the previous response.
+      if (!connection->WaitForIncomingData(std::chrono::milliseconds(0))) {
+        return connection;
+      }
+    }
+  }
+
+  void Return(const std::string& host, int port, std::unique_ptr<current::net::Connection> connection) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (max_idle_per_host_) {
+      auto& idle = idle_[std::make_pair(host, port)];
+      idle.push_back(Idle{std::move(connection), std::chrono::steady_clock::now()});
+      if (idle.size() > max_idle_per_host_) {
+        idle.pop_front();
+      }
+    }
+  }
+
+ private:
+  struct Idle final {
+    std::unique_ptr<current::net::Connection> connection;
+    std::chrono::steady_clock::time_point since;
+  };
+
+  mutable std::mutex mutex_;
+  size_t max_idle_per_host_ = kDefaultMaxIdlePerHost;
+  std::chrono::milliseconds idle_timeout_ = kDefaultIdleTimeout;
+  // From the oldest to the most recently returned one, per host and port.
+  std::map<std::pair<std::string, int>, std::deque<Idle>> idle_;
+};
+
+inline HTTPClientPOSIXConnectionPool& HTTPClientConnectionPool() {
+  return current::Singleton<HTTPClientPOSIXConnectionPool>();
+}
+
 template <class HTTP_HELPER>
 class GenericHTTPClientPOSIX final {
  private:
@@ -84,56 +186,30 @@ class GenericHTTPClientPOSIX final {
         CURRENT_THROW(current::net::HTTPRedirectLoopException(loop));
       }
       all_urls.insert(composed_url);
-      // The `URL` class' concern is to parse the URL string as is: if the port is missing, it becomes zero.
-      // `URL::DefaultPortForScheme` will return zero anyway if the schema is unknown.
-      // So, to make sure we don't try to connect to port zero, the defaulting logic has to be here in the HTTP client.
-      int port = parsed_url.port;
-      if (port == 0) {
-        port = URL::DefaultPortForScheme(parsed_url.scheme);
-        if (port == 0) {
-          port = 80;
-        }
-      }
-      current::net::Connection connection(current::net::Connection(current::net::ClientSocket(parsed_url.host, port)));
-      connection.BlockingWrite(
-          request_method_ + ' ' + parsed_url.path + parsed_url.ComposeParameters() + " HTTP/1.1\r\n", true);
-      connection.BlockingWrite("Host: " + parsed_url.host + "\r\n", true);
-      if (!request_user_agent_.empty()) {
-        connection.BlockingWrite("User-Agent: " + request_user_agent_ + "\r\n", true);
-      }
-      for (const auto& h : request_headers_) {
-        connection.BlockingWrite(h.header + ": " + h.value + "\r\n", true);
-      }
-      if (!request_headers_.cookies.empty()) {
-        connection.BlockingWrite("Cookie: " + request_headers_.CookiesAsString() + "\r\n", true);
-      }
-      if (!request_body_content_type_.empty()) {
-        connection.BlockingWrite("Content-Type: " + request_body_content_type_ + "\r\n", true);
-      }
-      if (!request_body_contents_.empty() || current::net::NeedContentLengthHeader(request_method_)) {
-        // NOTE(dkorolev): The `try/catch/throw` combo here is a hack for the unit test for HTTP 413 to pass.
-        // It swallows the `SocketWriteException` exception for huge payloads, as Current's HTTP server logic
-        // does intentionally close the HTTP connection prematurely if `Content-Length` exceeds a reasonable limit.
+      const int port = PortToConnectTo(parsed_url);
+      HTTPClientPOSIXConnectionPool& pool = HTTPClientConnectionPool();
+      const bool pooled = keep_alive_ && request_method_ != "HEAD" && pool.Enabled();
+      std::unique_ptr<current::net::Connection> connection = pooled ? pool.Take(parsed_url.host, port) : nullptr;
+      if (connection) {
         try {
-#ifndef CURRENT_WINDOWS
-          connection.BlockingWrite("Content-Length: " + std::to_string(request_body_contents_.length()) + "\r\n", true);
-          connection.BlockingWrite("\r\n", true);
-          connection.BlockingWrite(request_body_contents_, false);
-#else
-          // TODO(grixa): this fix for the PayloadTooLarge test on Windows is temporary, need to revisit it.
-          connection.BlockingWrite("Content-Length: " + std::to_string(request_body_contents_.length()) + "\r\n\r\n" +
-                                       request_body_contents_,
-                                   false);
-#endif
-        } catch (const net::SocketWriteException&) {
-          if (request_body_contents_.length() <= net::constants::kMaxHTTPPayloadSizeInBytes) {
+          SendRequestAndReadResponse(*connection, parsed_url);
+        } catch (const current::net::SocketException&) {
+          // The server may have closed the idle connection just as it was taken out of the pool.
+          // Repeat the request over a new connection, as long as repeating it is safe.
+          if (request_method_ == "POST" || request_method_ == "PATCH") {
             throw;
           }
+          connection = nullptr;
         }
-      } else {
-        connection.BlockingWrite("\r\n", false);
       }
-      http_request_.reset(new CustomHTTPRequestData(connection, request_data_construction_params_));
+      if (!connection) {
+        connection = std::make_unique<current::net::Connection>(current::net::ClientSocket(parsed_url.host, port));
+        SendRequestAndReadResponse(*connection, parsed_url);
+      }
+      if (pooled && http_request_->KeepAlive() &&
+          http_request_->headers().Has(current::net::constants::kContentLengthHeaderKey)) {
+        pool.Return(parsed_url.host, port, std::move(connection));
+      }
       // TODO(dkorolev): Rename `Path()`, it's only called so now because of HTTP request/response format.
       // Elaboration:
       // HTTP request  message is: `GET /path HTTP/1.1`, "/path" is the second component of it.
@@ -156,6 +232,71 @@ class GenericHTTPClientPOSIX final {
     return true;
   }
 
+  // The `URL` class' concern is to parse the URL string as is: if the port is missing, it becomes zero.
+  // `URL::DefaultPortForScheme` will return zero anyway if the schema is unknown.
+  // So, to make sure we don't try to connect to port zero, the defaulting logic has to be here in the HTTP client.
+  static int PortToConnectTo(const URL& parsed_url) {
+    int port = parsed_url.port;
+    if (port == 0) {
+      port = URL::DefaultPortForScheme(parsed_url.scheme);
+      if (port == 0) {
+        port = 80;
+      }
+    }
+    return port;
+  }
+
+  bool HasRequestBody() const {
+    return !request_body_contents_.empty() || current::net::NeedContentLengthHeader(request_method_);
+  }
+
+  // The request line and the headers of the request, up to and including the empty line that precedes the body.
+  std::string RequestHead(const URL& parsed_url) const {
+    std::string head = request_method_ + ' ' + parsed_url.path + parsed_url.ComposeParameters() + " HTTP/1.1\r\n";
+    head += "Host: " + parsed_url.host + "\r\n";
+    if (!request_user_agent_.empty()) {
+      head += "User-Agent: " + request_user_agent_ + "\r\n";
+    }
+    for (const auto& h : request_headers_) {
+      head += h.header + ": " + h.value + "\r\n";
+    }
+    if (!request_headers_.cookies.empty()) {
+      head += "Cookie: " + request_headers_.CookiesAsString() + "\r\n";
+    }
+    if (!request_body_content_type_.empty()) {
+      head += "Content-Type: " + request_body_content_type_ + "\r\n";
+    }
+    if (HasRequestBody()) {
+      head += "Content-Length: " + std::to_string(request_body_contents_.length()) + "\r\n";
+    }
+    return head + "\r\n";
+  }
+
+  // Sends the request over the connection, and reads the response from it into `http_request_`.
+  void SendRequestAndReadResponse(current::net::Connection& connection, const URL& parsed_url) {
+    if (HasRequestBody()) {
+      // NOTE(dkorolev): The `try/catch/throw` combo here is a hack for the unit test for HTTP 413 to pass.
+      // It swallows the `SocketWriteException` exception for huge payloads, as Current's HTTP server logic
+      // does intentionally close the HTTP connection prematurely if `Content-Length` exceeds a reasonable limit.
+      try {
+#ifndef CURRENT_WINDOWS
+        connection.BlockingWrite(RequestHead(parsed_url), true);
+        connection.BlockingWrite(request_body_contents_, false);
+#else
+        // TODO(grixa): this fix for the PayloadTooLarge test on Windows is temporary, need to revisit it.
+        connection.BlockingWrite(RequestHead(parsed_url) + request_body_contents_, false);
+#endif
+      } catch (const net::SocketWriteException&) {
+        if (request_body_contents_.length() <= net::constants::kMaxHTTPPayloadSizeInBytes) {
+          throw;
+        }
+      }
+    } else {
+      connection.BlockingWrite(RequestHead(parsed_url), false);
+    }
+    http_request_.reset(new CustomHTTPRequestData(connection, request_data_construction_params_));
+  }
+
   const CustomHTTPRequestData& HTTPRequest() const { return *http_request_.get(); }
 
  public:
@@ -168,6 +309,7 @@ class GenericHTTPClientPOSIX final {
   current::net::http::Headers request_headers_;
   const typename HTTP_HELPER::ConstructionParams request_data_construction_params_;
   bool allow_redirects_ = false;
+  bool keep_alive_ = true;
 
   // Output parameters.
   current::net::HTTPResponseCodeValue response_code_ = HTTPResponseCode.InvalidCode;
@@ -187,6 +329,7 @@ struct ImplWrapper<HTTPClientPOSIX> {
     client.request_user_agent_ = request.custom_user_agent;
     client.request_headers_ = request.custom_headers;
     client.allow_redirects_ = request.allow_redirects;
+    client.keep_alive_ = request.keep_alive;
   }
 
   inline static void PrepareInput(const HEAD& request, HTTPClientPOSIX& client) {
@@ -195,6 +338,7 @@ struct ImplWrapper<HTTPClientPOSIX> {
     client.request_user_agent_ = request.custom_user_agent;
     client.request_headers_ = request.custom_headers;
     client.allow_redirects_ = request.allow_redirects;
+    client.keep_alive_ = request.keep_alive;
   }
 
   inline static void PrepareInput(const POST& request, HTTPClientPOSIX& client) {
@@ -205,6 +349,7 @@ struct ImplWrapper<HTTPClientPOSIX> {
     client.request_body_contents_ = request.body;
     client.request_body_content_type_ = request.content_type;
     client.allow_redirects_ = request.allow_redirects;
+    client.keep_alive_ = request.keep_alive;
   }
 
   inline static void PrepareInput(const POSTFromFile& request, HTTPClientPOSIX& client) {
@@ -216,6 +361,7 @@ struct ImplWrapper<HTTPClientPOSIX> {
         current::FileSystem::ReadFileAsString(request.file_name);  // Can throw FileException.
     client.request_body_content_type_ = request.content_type;
     client.allow_redirects_ = request.allow_redirects;
+    client.keep_alive_ = request.keep_alive;
   }
 
   inline static void PrepareInput(const PUT& request, HTTPClientPOSIX& client) {
@@ -226,6 +372,7 @@ struct ImplWrapper<HTTPClientPOSIX> {
     client.request_body_contents_ = request.body;
     client.request_body_content_type_ = request.content_type;
     client.allow_redirects_ = request.allow_redirects;
+    client.keep_alive_ = request.keep_alive;
   }
 
   inline static void PrepareInput(const PATCH& request, HTTPClientPOSIX& client) {
@@ -236,6 +383,7 @@ struct ImplWrapper<HTTPClientPOSIX> {
     client.request_body_contents_ = request.body;
     client.request_body_content_type_ = request.content_type;
     client.allow_redirects_ = request.allow_redirects;
+    client.keep_alive_ = request.keep_alive;
   }
 
   inline static void PrepareInput(const DELETE& request, HTTPClientPOSIX& client) {
@@ -244,6 +392,7 @@ struct ImplWrapper<HTTPClientPOSIX> {
     client.request_user_agent_ = request.custom_user_agent;  // LCOV_EXCL_LINE  -- tested in GET above.
     client.request_headers_ = request.custom_headers;
     client.allow_redirects_ = request.allow_redirects;
+    client.keep_alive_ = request.keep_alive;
   }
 
   inline static void PrepareInput(const KeepResponseInMemory&, HTTPClientPOSIX&) {}
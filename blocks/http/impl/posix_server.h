@@ -26,15 +26,21 @@ SOFTWARE.
 #define BLOCKS_HTTP_IMPL_POSIX_SERVER_H
 
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <string>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <thread>
+#include <vector>
 #include <iostream>  // TODO(dkorolev): More robust logging here.
 
 #include "../types.h"
 #include "../request.h"
 
+#include "router.h"
+
 #include "../../url/url.h"
 
 #include "../../../typesystem/optional.h"
@@ -156,6 +162,12 @@ struct StaticFileServer {
   }
 };
 
+// How the extra serving threads of `HTTPServerPOSIX::SetThreads()` get their connections.
+// * `Shared`: All the threads block in `accept()` on the very listening socket of the port.
+// * `ReusePort`: Each extra thread listens on a socket of its own, bound to the same port with `SO_REUSEPORT`,
+//                and the kernel spreads the incoming connections across these sockets. Linux only.
+enum class HTTPServerListeners : bool { Shared, ReusePort };
+
 // HTTP server bound to a specific port.
 class HTTPServerPOSIX final {
  public:
@@ -163,46 +175,127 @@ class HTTPServerPOSIX final {
   // Since instances of `HTTPServerPOSIX` are created via a singleton,
   // a listening thread will only be created once per port, on the first access to that port.
   explicit HTTPServerPOSIX(current::net::BarePort port)
-      : terminating_(false),
-        port_(static_cast<uint16_t>(port)),
-        thread_([this, port]() { Thread(current::net::Socket(port)); }) {}
+      : terminating_(false), port_(static_cast<uint16_t>(port)) {
+    StartThread(std::make_unique<current::net::Socket>(port));
+  }
   explicit HTTPServerPOSIX(current::net::ReservedLocalPort reserved_port)
-      : terminating_(false),
-        port_(reserved_port),
-        thread_([this](current::net::Socket socket) { Thread(std::move(socket)); }, std::move(reserved_port)) {}
+      : terminating_(false), port_(reserved_port) {
+    StartThread(std::make_unique<current::net::Socket>(std::move(reserved_port)));
+  }
 
   uint16_t LocalPort() const { return port_; }
 
+  // By default, a port is served by one thread, which accepts the connection, parses the request,
+  // and runs the handler, so that a slow handler holds back every request that comes after it.
+  // `SetThreads(n)` grows the number of threads serving this port to `n`, each of them running the very loop
+  // of the first one, with the same routes. It never shrinks the pool, so asking for fewer threads is a no-op.
+  // Once there is more than one thread, the handlers of this port may be called concurrently.
+  HTTPServerPOSIX& SetThreads(size_t threads, HTTPServerListeners listeners = HTTPServerListeners::Shared) {
+    std::lock_guard<std::mutex> lock(threads_mutex_);
+    if (listeners == HTTPServerListeners::ReusePort && threads > threads_.size()) {
+      // Let the sockets of the new threads bind to the port the first one is already listening on.
+      listeners_.front()->EnableReusePort();
+    }
+    while (threads_.size() < threads) {
+      if (listeners == HTTPServerListeners::Shared) {
+        current::net::Socket& socket = *listeners_.front();
+        threads_.emplace_back([this, &socket]() { Thread(socket); });
+        ++threads_sharing_first_listener_;
+      } else {
+        listeners_.push_back(std::make_unique<current::net::Socket>(current::net::BarePort(port_),
+                                                                    current::net::kDefaultNagleAlgorithmPolicy,
+                                                                    current::net::kMaxServerQueuedConnections,
+                                                                    current::net::ReusePort::Enable));
+        current::net::Socket& socket = *listeners_.back();
+        threads_.emplace_back([this, &socket]() { Thread(socket); });
+      }
+    }
+    StartKeepAliveThreads();
+    return *this;
+  }
+
+  size_t Threads() const {
+    std::lock_guard<std::mutex> lock(threads_mutex_);
+    return threads_.size();
+  }
+
+  // Persistent HTTP/1.1 connections, off by default. With them on, the connection is kept open after the response,
+  // unless the client asks otherwise, and the next request is read from it, so that the pipelined requests are served
+  // in order. The connection is closed after `max_requests` requests, once it has been idle for `idle_timeout`,
+  // or if the request is answered from another thread after its handler has returned.
+  // On Linux, the idle connections are parked in the `Reactor` of this server, and their next requests are served
+  // by as many extra threads as there are serving threads, so that the idle clients cost no threads.
+  // Elsewhere, the thread that has served the request waits for the next one, so use `SetThreads()` for more clients.
+  HTTPServerPOSIX& SetKeepAlive(std::chrono::milliseconds idle_timeout, size_t max_requests = 100u) {
+#ifdef CURRENT_POSIX
+    if (idle_timeout.count()) {
+      std::lock_guard<std::mutex> lock(threads_mutex_);
+      if (!reactor_) {
+        reactor_ = std::make_unique<current::net::Reactor>();
+        StartKeepAliveThreads();
+      }
+    }
+#endif  // CURRENT_POSIX
+    keep_alive_max_requests_ = max_requests;
+    keep_alive_idle_timeout_ms_ = idle_timeout.count();
+    return *this;
+  }
+  HTTPServerPOSIX& DisableKeepAlive() { return SetKeepAlive(std::chrono::milliseconds(0)); }
+
   // The destructor closes the socket.
   // Note that the destructor will only be run on the shutdown of the binary,
   // unregistering all handlers will still keep the listening thread up, and it will serve 404-s.
   ~HTTPServerPOSIX() {
     terminating_ = true;
-    // Notify the server thread that it should terminate.
+    std::lock_guard<std::mutex> lock(threads_mutex_);
+#ifdef CURRENT_POSIX
+    // The threads with listening sockets of their own can not be reliably reached by a request, as the kernel
+    // picks the socket to deliver a connection to. Shutting such a socket down fails the pending `accept()`,
+    // and also takes the socket out of the `SO_REUSEPORT` group, so that the requests below all land on the first one.
+    for (size_t i = 1u; i < listeners_.size(); ++i) {
+      ::shutdown(listeners_[i]->socket, SHUT_RD);
+    }
+#endif  // CURRENT_POSIX
+    // Notify the server threads that they should terminate, one request per thread of the first socket.
     // Effectively, call `HTTP(GET("/healthz"))`, but in a way that avoids client <=> server dependency.
     // LCOV_EXCL_START
-    try {
-      // TODO(dkorolev): This should always use the POSIX implemenation of the client, nothing fancier.
-      // It is a safe call, since the server itself is POSIX, so the architecture we are on is POSIX-friendly.
-      current::net::Connection(current::net::ClientSocket("localhost", port_))
-          .BlockingWrite("GET /healthz HTTP/1.1\r\n\r\n", true);
-    } catch (const current::Exception&) {
-      // It is guaranteed that after `terminated_` is set the server will be terminated on the next request,
-      // but it might so happen that that terminating request will happen between `terminating_ = true`
-      // and the consecutive request. Which is perfectly fine, since it implies that the server has terminated.
+    for (size_t i = 0u; i < threads_sharing_first_listener_; ++i) {
+      try {
+        // TODO(dkorolev): This should always use the POSIX implemenation of the client, nothing fancier.
+        // It is a safe call, since the server itself is POSIX, so the architecture we are on is POSIX-friendly.
+        current::net::Connection(current::net::ClientSocket("localhost", port_))
+            .BlockingWrite("GET /healthz HTTP/1.1\r\n\r\n", true);
+      } catch (const current::Exception&) {
+        // It is guaranteed that after `terminated_` is set the server will be terminated on the next request,
+        // but it might so happen that that terminating request will happen between `terminating_ = true`
+        // and the consecutive request. Which is perfectly fine, since it implies that the server has terminated.
+      }
     }
     // LCOV_EXCL_STOP
-    // Wait for the thread to terminate.
-    if (thread_.joinable()) {
-      thread_.join();
+    {
+      std::lock_guard<std::mutex> ready_lock(ready_mutex_);
+      ready_cv_.notify_all();
+    }
+    // Wait for the threads to terminate.
+    for (std::thread& thread : threads_) {
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+    for (std::thread& thread : keep_alive_threads_) {
+      thread.join();
     }
+#ifdef CURRENT_POSIX
+    // Closes the connections still parked, with no more of them becoming ready.
+    reactor_ = nullptr;
+#endif  // CURRENT_POSIX
   }
 
   // The bare `Join()` method is only used by small scripts to run the server indefinitely,
   // instead of `while(true)`
   // LCOV_EXCL_START
   void Join() {
-    thread_.join();  // May throw.
+    threads_.front().join();  // May throw.
   }
   // LCOV_EXCL_STOP
 
@@ -260,20 +353,9 @@ class HTTPServerPOSIX final {
     URLPathArgs::CountMask mask = URLPathArgs::CountMask::None;  // `None` == 1 == (1 << 0).
     for (size_t i = 0; i <= URLPathArgs::MaxArgsCount; ++i, mask <<= 1) {
       if ((path_args_count_mask & mask) == mask) {
-        auto it1 = handlers_.find(path);
-        if (it1 == handlers_.end()) {
+        if (!routes_.Erase(path, i)) {
           CURRENT_THROW(HandlerDoesNotExistException(path));
         }
-        auto& map = it1->second;
-        auto it2 = map.find(i);
-        if (it2 == map.end()) {
-          CURRENT_THROW(HandlerDoesNotExistException(path));
-        }
-        map.erase(it2);
-        if (map.empty()) {
-          // Maintain the value of `PathHandlersCount()` invariant.
-          handlers_.erase(it1);
-        }
       }
     }
   }
@@ -324,7 +406,7 @@ class HTTPServerPOSIX final {
             // If it's an index file, serve it additionally at the route without the filename (i.e. the directory
             // route).
             if (is_index_file) {
-              if (handlers_.find(route_for_directory) != handlers_.end()) {
+              if (routes_.Find(route_for_directory)) {
                 CURRENT_THROW(ServeStaticFilesFromCannotServeMoreThanOneIndexFile(route_for_directory + ' ' +
                                                                                   item_info.basename));
               }
@@ -357,7 +439,7 @@ class HTTPServerPOSIX final {
     // NOTE: The total number of handlers is no longer an interesting measure.
     //       Just return the number of distinct paths, which may be path prefixes.
     std::lock_guard<std::mutex> lock(mutex_);
-    return handlers_.size();
+    return routes_.PathsCount();
   }
 
  private:
@@ -381,49 +463,59 @@ class HTTPServerPOSIX final {
     }
     // LCOV_EXCL_STOP
 
-    // Work with the path by trying to match the full one, then the one with the last component removed,
-    // then the one with two last components removed, etc.
-    // As a component is removed, it's removed from `base_path` and is added to `url_args`.
-    std::string& remaining_path = output_url_args.base_path;
-    remaining_path = path;
+    // See `URLPathRoutes` for how the path is matched.
+    const auto handler = routes_.Match(path, output_url_args);
+    if (handler) {
+      return Borrowed<std::function<void(Request)>>(*handler);
+    } else {
+      return nullptr;
+    }
+  }
 
-    // Friendly reminder: `remaining_path[0]` is guaranteed to be '/'.
-    while (true) {
-      while (remaining_path.length() > 1 && remaining_path.back() == '/') {
-        remaining_path.resize(remaining_path.length() - 1);
-      }
+  void StartThread(std::unique_ptr<current::net::Socket> socket) {
+    current::net::Socket& listener = *socket;
+    listeners_.push_back(std::move(socket));
+    threads_.emplace_back([this, &listener]() { Thread(listener); });
+    threads_sharing_first_listener_ = 1u;
+  }
 
-      const auto cit = handlers_.find(remaining_path);
-      if (cit != handlers_.end()) {
-        const auto cit2 = cit->second.find(output_url_args.size());
-        if (cit2 != cit->second.end()) {
-          return Borrowed<std::function<void(Request)>>(cit2->second);
+  // Run by each serving thread of the port. See `examples/benchmark/http` for the QPS and latency numbers.
+  void Thread(current::net::Socket& socket) {
+    while (!terminating_) {
+      std::unique_ptr<current::net::Connection> connection;
+      try {
+        connection = std::make_unique<current::net::Connection>(socket.Accept());
+      } catch (const current::net::SocketAcceptException&) {  // LCOV_EXCL_LINE
+        // The listening socket of this thread has been shut down by the destructor.
+        if (!terminating_) {
+          std::cerr << "HTTP server failed to accept a connection on port " << port_ << ".\n";  // LCOV_EXCL_LINE
         }
+        continue;
       }
-
-      if (remaining_path == "/") {
-        break;
-      }
-
-      const size_t arg_begin_index = remaining_path.rfind('/') + 1;
-      output_url_args.add(URL::DecodeURIComponent(remaining_path.substr(arg_begin_index)));
-      remaining_path.resize(arg_begin_index);
+      ServeConnection(std::move(connection), 0u);
     }
-
-    return nullptr;
   }
 
-  void Thread(current::net::Socket socket) {
-    // TODO(dkorolev): Benchmark QPS.
-    while (!terminating_) {
+  // Serves the requests over the connection for as long as it is kept alive and has the next request ready.
+  // The pipelined requests are thus served one after another, in the order they came in. Once the kept alive
+  // connection is idle, it is parked in the reactor, or, where there is none, waited for by this very thread.
+  void ServeConnection(std::unique_ptr<current::net::Connection> tcp_connection, size_t requests_served) {
+    while (tcp_connection && !terminating_) {
       try {
-        auto connection = std::make_unique<current::net::HTTPServerConnection>(socket.Accept());
+        const std::unique_ptr<current::net::Connection> incoming = std::move(tcp_connection);
+        auto connection = std::make_unique<current::net::HTTPServerConnection>(std::move(*incoming));
         if (terminating_) {
           // Already terminating. Will not send the response, and this
           // lack of response should not result in an exception.
           connection->DoNotSendAnyResponse();
           break;
         }
+        std::shared_ptr<current::net::HTTPKeepAlive> keep_alive;
+        const std::chrono::milliseconds idle_timeout(keep_alive_idle_timeout_ms_);
+        if (idle_timeout.count() && ++requests_served < keep_alive_max_requests_) {
+          keep_alive = std::make_shared<current::net::HTTPKeepAlive>();
+          connection->KeepAlive(keep_alive);
+        }
         URLPathArgs url_path_args;
         const auto handler = FindHandler(connection->HTTPRequest().URL().path, url_path_args);
         if (Exists(handler)) {
@@ -458,6 +550,19 @@ class HTTPServerPOSIX final {
                                        HTTPResponseCode.NotFound,
                                        current::net::http::Headers(),
                                        current::net::constants::kDefaultHTMLContentType);
+          connection = nullptr;
+        }
+        if (keep_alive) {
+          tcp_connection = keep_alive->StopWaiting();
+          if (tcp_connection && !tcp_connection->WaitForIncomingData(std::chrono::milliseconds(0))) {
+#ifdef CURRENT_POSIX
+            Park(std::move(tcp_connection), idle_timeout, requests_served);
+#else
+            if (!WaitForNextRequest(*tcp_connection, idle_timeout)) {
+              tcp_connection = nullptr;
+            }
+#endif  // CURRENT_POSIX
+          }
         }
       } catch (const current::net::ChunkSizeNotAValidHEXValue&) {
         // The `ChunkSizeNotAValidHEXValue` situation, if emerged, is already handled with a "400 BAD REQUEST" response.
@@ -474,6 +579,66 @@ class HTTPServerPOSIX final {
     }
   }
 
+#ifdef CURRENT_POSIX
+  // Hands the idle kept alive connection over to the reactor, for one of the keep-alive threads to serve
+  // its next request once it comes.
+  void Park(std::unique_ptr<current::net::Connection> connection,
+            std::chrono::milliseconds idle_timeout,
+            size_t requests_served) {
+    reactor_->Park(std::move(connection),
+                   idle_timeout,
+                   [this, requests_served](std::unique_ptr<current::net::Connection> readable) {
+                     {
+                       std::lock_guard<std::mutex> lock(ready_mutex_);
+                       ready_.emplace_back(std::move(readable), requests_served);
+                     }
+                     ready_cv_.notify_one();
+                   });
+  }
+#else
+  // Waits for the next request over a kept alive connection, keeping an eye on the server being shut down.
+  bool WaitForNextRequest(current::net::Connection& connection, std::chrono::milliseconds idle_timeout) {
+    const auto give_up = std::chrono::steady_clock::now() + idle_timeout;
+    while (!terminating_) {
+      const auto remaining =
+          std::chrono::duration_cast<std::chrono::milliseconds>(give_up - std::chrono::steady_clock::now());
+      if (remaining.count() <= 0) {
+        return false;
+      }
+      if (connection.WaitForIncomingData(std::min(remaining, std::chrono::milliseconds(50)))) {
+        return true;
+      }
+    }
+    return false;
+  }
+#endif  // CURRENT_POSIX
+
+  // Under `threads_mutex_`. Keeps as many keep-alive threads as there are serving threads, once there is a reactor.
+  void StartKeepAliveThreads() {
+#ifdef CURRENT_POSIX
+    if (reactor_) {
+      while (keep_alive_threads_.size() < threads_.size()) {
+        keep_alive_threads_.emplace_back([this]() { KeepAliveThread(); });
+      }
+    }
+#endif  // CURRENT_POSIX
+  }
+
+  // Serves the kept alive connections the reactor has found the next requests in.
+  void KeepAliveThread() {
+    while (true) {
+      std::unique_lock<std::mutex> lock(ready_mutex_);
+      ready_cv_.wait(lock, [this]() { return terminating_ || !ready_.empty(); });
+      if (terminating_) {
+        return;
+      }
+      auto next = std::move(ready_.front());
+      ready_.pop_front();
+      lock.unlock();
+      ServeConnection(std::move(next.first), next.second);
+    }
+  }
+
   void ValidateRoute(const std::string& path) {
     if (path.empty() || path[0] != '/') {
       CURRENT_THROW(PathDoesNotStartWithSlash("HTTP URL path does not start with a slash: `" + path + "`."));
@@ -500,12 +665,11 @@ class HTTPServerPOSIX final {
 
     {
       // Step 1: Confirm the request is valid.
-      const auto handlers_per_path_iterator = handlers_.find(path);
+      const auto handlers_per_path = routes_.Find(path);
       URLPathArgs::CountMask mask = URLPathArgs::CountMask::None;  // `None` == 1 == (1 << 0).
       for (size_t i = 0; i <= URLPathArgs::MaxArgsCount; ++i, mask = mask << 1) {
         if ((path_args_count_mask & mask) == mask) {
-          if (handlers_per_path_iterator == handlers_.end() ||
-              handlers_per_path_iterator->second.find(i) == handlers_per_path_iterator->second.end()) {
+          if (!handlers_per_path || handlers_per_path->find(i) == handlers_per_path->end()) {
             // No such handler. Throw if trying to "Update" it.
             if (policy == ReRegisterRoute::SilentlyUpdateExisting) {
               CURRENT_THROW(HandlerDoesNotExistException(path));
@@ -522,11 +686,10 @@ class HTTPServerPOSIX final {
 
     {
       // Step 2: Update.
-      auto& handlers_per_path = handlers_[path];
       URLPathArgs::CountMask mask = URLPathArgs::CountMask::None;  // `None` == 1 == (1 << 0).
       for (size_t i = 0; i <= URLPathArgs::MaxArgsCount; ++i, mask = mask << 1) {
         if ((path_args_count_mask & mask) == mask) {
-          handlers_per_path[i] = MakeOwned<std::function<void(Request)>>(handler);
+          routes_.Insert(path, i, MakeOwned<std::function<void(Request)>>(handler));
         }
       }
     }
@@ -542,12 +705,32 @@ class HTTPServerPOSIX final {
 
   std::atomic_bool terminating_;
   const uint16_t port_;
-  std::thread thread_;
+
+  // Zero idle timeout stands for the keep-alive being off.
+  std::atomic<int64_t> keep_alive_idle_timeout_ms_{0};
+  std::atomic<size_t> keep_alive_max_requests_{0u};
+
+  // The first listening socket is the one the server was constructed with, the rest are `SO_REUSEPORT` ones.
+  // Declared before `threads_`, so that the sockets outlive the threads blocked in `accept()` on them.
+  mutable std::mutex threads_mutex_;
+  std::vector<std::unique_ptr<current::net::Socket>> listeners_;
+  size_t threads_sharing_first_listener_ = 0u;
+  std::vector<std::thread> threads_;
+
+  // The kept alive connections with their next requests ready, along with the numbers of requests served over them.
+  std::mutex ready_mutex_;
+  std::condition_variable ready_cv_;
+  std::deque<std::pair<std::unique_ptr<current::net::Connection>, size_t>> ready_;
+  std::vector<std::thread> keep_alive_threads_;
+#ifdef CURRENT_POSIX
+  // Where the idle kept alive connections wait for their next requests. Created by `SetKeepAlive()`.
+  std::unique_ptr<current::net::Reactor> reactor_;
+#endif  // CURRENT_POSIX
 
   // TODO(dkorolev): Look into read-write mutexes here.
   mutable std::mutex mutex_;
 
-  std::map<std::string, std::map<size_t, Owned<std::function<void(Request)>>>> handlers_;
+  URLPathRoutes<Owned<std::function<void(Request)>>> routes_;
   std::vector<std::unique_ptr<StaticFileServer>> static_file_servers_;
 };
 
@@ -0,0 +1,196 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2026 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// The routes of the HTTP server, kept as a trie of the path components, so that a request path is matched
+// in a single pass over it, with no copies made of its components.
+//
+// The semantics are those of matching the full path first, and then the path with one, two, etc. trailing components
+// removed and treated as the URL path arguments: the longest registered path that has a handler for the number
+// of the remaining components wins. Empty components are skipped, i.e. `/foo//bar/` is `/foo` with one argument.
+// The arguments are only URL-decoded once the route has been found.
+
+#ifndef BLOCKS_HTTP_IMPL_ROUTER_H
+#define BLOCKS_HTTP_IMPL_ROUTER_H
+
+#include "../../../port.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "../../url/url.h"
+
+namespace current {
+namespace http {
+
+template <typename T>
+class URLPathRoutes final {
+ public:
+  using handlers_t = std::map<size_t, T>;
+
+  URLPathRoutes() : root_(nullptr, "/", 0u) {}
+
+  // The handlers of the very `path`, not matching it against shorter paths. Returns `nullptr` if there are none.
+  const handlers_t* Find(const std::string& path) const {
+    const Node* node = &root_;
+    ForEachComponent(path, [&node](std::string_view component) {
+      if (node) {
+        const auto cit = node->children.find(component);
+        node = (cit != node->children.end()) ? cit->second.get() : nullptr;
+      }
+    });
+    return (node && !node->handlers.empty()) ? &node->handlers : nullptr;
+  }
+
+  void Insert(const std::string& path, size_t args_count, T value) {
+    Node* node = &root_;
+    ForEachComponent(path, [&node](std::string_view component) {
+      auto& child = node->children[std::string(component)];
+      if (!child) {
+        const std::string child_path = (node->parent ? node->path : "") + '/' + std::string(component);
+        child = std::make_unique<Node>(node, child_path, node->depth + (component.empty() ? 0u : 1u));
+      }
+      node = child.get();
+    });
+    if (node->handlers.empty()) {
+      ++paths_;
+    }
+    node->handlers[args_count] = std::move(value);
+  }
+
+  // Returns `false` if there was no such handler. Removes the components no longer leading to any handlers.
+  bool Erase(const std::string& path, size_t args_count) {
+    Node* node = &root_;
+    ForEachComponent(path, [&node](std::string_view component) {
+      if (node) {
+        const auto it = node->children.find(component);
+        node = (it != node->children.end()) ? it->second.get() : nullptr;
+      }
+    });
+    if (!node || !node->handlers.erase(args_count)) {
+      return false;
+    }
+    if (node->handlers.empty()) {
+      --paths_;
+    }
+    while (node->parent && node->handlers.empty() && node->children.empty()) {
+      Node* parent = node->parent;
+      for (auto it = parent->children.begin(); it != parent->children.end(); ++it) {
+        if (it->second.get() == node) {
+          parent->children.erase(it);
+          break;
+        }
+      }
+      node = parent;
+    }
+    return true;
+  }
+
+  // The number of distinct paths with handlers.
+  size_t PathsCount() const { return paths_; }
+
+  // Finds the handler for the request `path`, and fills `output_url_args` with the path it is registered at
+  // and with the URL-decoded arguments. Returns `nullptr` if there is no such handler.
+  const T* Match(const std::string& path, URLPathArgs& output_url_args) const {
+    // Walk the trie as deep as the components of the path lead, counting the non-empty components along the way.
+    const Node* node = &root_;
+    const Node* deepest = &root_;
+    size_t components = 0u;
+    ForEachComponent(path, [&](std::string_view component) {
+      if (node) {
+        const auto cit = node->children.find(component);
+        node = (cit != node->children.end()) ? cit->second.get() : nullptr;
+        if (node && !component.empty()) {
+          deepest = node;
+        }
+      }
+      if (!component.empty()) {
+        ++components;
+      }
+    });
+    // The deepest route wins, as long as it has the handler for the number of the components that follow it.
+    for (const Node* candidate = deepest; candidate; candidate = candidate->parent) {
+      const auto cit = candidate->handlers.find(components - candidate->depth);
+      if (cit != candidate->handlers.end()) {
+        output_url_args.base_path = candidate->path;
+        // `URLPathArgs` keeps the arguments last to first.
+        const std::string_view args(path.data() + candidate->path.length(), path.length() - candidate->path.length());
+        size_t end = args.length();
+        while (end) {
+          const size_t slash = args.rfind('/', end - 1u);
+          const size_t begin = (slash == std::string_view::npos) ? 0u : slash + 1u;
+          if (begin < end) {
+            output_url_args.add(Decode(args.substr(begin, end - begin)));
+          }
+          end = (slash == std::string_view::npos) ? 0u : slash;
+        }
+        return &cit->second;
+      }
+    }
+    return nullptr;
+  }
+
+ private:
+  struct Node final {
+    Node* const parent;
+    const std::string path;  // The registered path leading to this node, which the request path begins with.
+    const size_t depth;      // The number of non-empty components in `path`.
+    std::map<std::string, std::unique_ptr<Node>, std::less<>> children;
+    handlers_t handlers;
+
+    Node(Node* parent, std::string path, size_t depth) : parent(parent), path(std::move(path)), depth(depth) {}
+  };
+
+  // Calls `f` with each component of the path, which always begins with a slash. The trailing empty one is skipped.
+  template <typename F>
+  static void ForEachComponent(const std::string& path, F&& f) {
+    size_t begin = 1u;
+    while (begin < path.length()) {
+      size_t end = path.find('/', begin);
+      if (end == std::string::npos) {
+        end = path.length();
+      }
+      f(std::string_view(path.data() + begin, end - begin));
+      begin = end + 1u;
+    }
+  }
+
+  static std::string Decode(std::string_view component) {
+    if (component.find_first_of("%+") == std::string_view::npos) {
+      return std::string(component);
+    } else {
+      return URL::DecodeURIComponent(std::string(component));
+    }
+  }
+
+  Node root_;
+  size_t paths_ = 0u;
+};
+
+}  // namespace http
+}  // namespace current
+
+#endif  // BLOCKS_HTTP_IMPL_ROUTER_H
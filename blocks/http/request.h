@@ -124,6 +124,19 @@ struct Request final {
     return connection.SendChunkedHTTPResponse<CACHE_SIZE>(code, headers, content_type);
   }
 
+#ifdef CURRENT_POSIX
+  current::net::ReactorChunkedResponseSender SendChunkedResponseViaReactor(
+      net::HTTPResponseCodeValue code = HTTPResponseCode.OK,
+      const net::http::Headers& headers = net::http::Headers(),
+      const std::string& content_type = net::constants::kDefaultJSONContentType,
+      current::net::Reactor& reactor = current::net::DefaultReactor()) {
+    if (!unique_connection) {
+      CURRENT_THROW(net::AttemptedToSendHTTPResponseMoreThanOnce());
+    }
+    return connection.SendChunkedHTTPResponseViaReactor(code, headers, content_type, reactor);
+  }
+#endif  // CURRENT_POSIX
+
   Request(const Request&) = delete;
   void operator=(const Request&) = delete;
   void operator=(Request&&) = delete;
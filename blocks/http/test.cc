@@ -237,6 +237,48 @@ TEST(HTTPAPI, ComposeURLPathWithURLPathArgs) {
   EXPECT_EQ("/ (/user/a/1/blah, /user/a/1/blah)", run("/user/a/1/blah/"));
 }
 
+TEST(HTTPAPI, URLPathRoutes) {
+  current::http::URLPathRoutes<std::string> routes;
+  routes.Insert("/", 1u, "root");
+  routes.Insert("/a", 0u, "a");
+  routes.Insert("/a/b", 1u, "a/b");
+  routes.Insert("/a/b/c", 0u, "a/b/c");
+  routes.Insert("/a//x", 0u, "a//x");
+  EXPECT_EQ(5u, routes.PathsCount());
+
+  const auto match = [&routes](const std::string& path) -> std::string {
+    URLPathArgs args;
+    const std::string* value = routes.Match(path, args);
+    return value ? *value + " " + args.base_path + " (" + current::strings::Join(args, ", ") + ")" : "none";
+  };
+
+  EXPECT_EQ("a /a ()", match("/a"));
+  EXPECT_EQ("a /a ()", match("/a//"));
+  EXPECT_EQ("a/b/c /a/b/c ()", match("/a/b/c"));
+  EXPECT_EQ("a/b /a/b (d)", match("/a/b/d"));
+  EXPECT_EQ("a/b /a/b (c d)", match("/a/b/c+d"));
+  EXPECT_EQ("a/b /a/b (c/d)", match("/a/b//c%2Fd/"));
+  EXPECT_EQ("root / (b)", match("/b"));
+  EXPECT_EQ("none", match("/a/b"));
+  EXPECT_EQ("none", match("/a/b/c/d/e"));
+  EXPECT_EQ("a//x /a//x ()", match("/a//x"));
+  EXPECT_EQ("none", match("/a/x"));
+
+  ASSERT_TRUE(routes.Find("/a/b") != nullptr);
+  EXPECT_TRUE(routes.Find("/a/b/c/d") == nullptr);
+  EXPECT_TRUE(routes.Erase("/a/b/c", 0u));
+  EXPECT_FALSE(routes.Erase("/a/b/c", 0u));
+  EXPECT_FALSE(routes.Erase("/a/b", 0u));
+  EXPECT_EQ(4u, routes.PathsCount());
+  EXPECT_EQ("a/b /a/b (c)", match("/a/b/c"));
+  EXPECT_TRUE(routes.Erase("/a//x", 0u));
+  EXPECT_TRUE(routes.Erase("/a/b", 1u));
+  EXPECT_EQ("none", match("/a/b/c"));
+  EXPECT_EQ("none", match("/a//x"));
+  EXPECT_EQ("root / (x)", match("/x"));
+  EXPECT_EQ(2u, routes.PathsCount());
+}
+
 TEST(HTTPAPI, ScopedUnRegister) {
   auto reserved_port = current::net::ReserveLocalPort();
   const int port = reserved_port;
@@ -2056,3 +2098,323 @@ TEST(HTTPAPI, JSONDoesHaveCORSHeaderByDefault) {
     EXPECT_EQ("*", response.headers.Get("Access-Control-Allow-Origin"));
   }
 }
+
+TEST(HTTPAPI, SlowHandlerDoesNotHoldBackOtherThreads) {
+  auto reserved_port = current::net::ReserveLocalPort();
+  const int port = reserved_port;
+  auto& http_server = HTTP(std::move(reserved_port));
+  EXPECT_EQ(1u, http_server.Threads());
+  EXPECT_EQ(4u, http_server.SetThreads(4).Threads());
+  EXPECT_EQ(4u, http_server.SetThreads(2).Threads());
+
+  std::atomic_bool fast_served(false);
+  const auto scope = http_server.Register("/slow",
+                                          [&fast_served](Request r) {
+                                            const auto give_up = std::chrono::steady_clock::now() +
+                                                                 std::chrono::seconds(5);
+                                            while (!fast_served && std::chrono::steady_clock::now() < give_up) {
+                                              std::this_thread::yield();
+                                            }
+                                            r(fast_served ? "slow\n" : "held back\n");
+                                          }) +
+                     http_server.Register("/fast", [&fast_served](Request r) {
+                       r("fast\n");
+                       fast_served = true;
+                     });
+
+  std::string slow_body;
+  std::thread slow([&slow_body, port]() { slow_body = HTTP(GET(Printf("http://localhost:%d/slow", port))).body; });
+  EXPECT_EQ("fast\n", HTTP(GET(Printf("http://localhost:%d/fast", port))).body);
+  slow.join();
+  EXPECT_EQ("slow\n", slow_body);
+}
+
+#ifdef CURRENT_POSIX
+TEST(HTTPAPI, ReusePortListeners) {
+  auto reserved_port = current::net::ReserveLocalPort();
+  const int port = reserved_port;
+  auto& http_server = HTTP(std::move(reserved_port));
+  EXPECT_EQ(4u, http_server.SetThreads(4, current::http::HTTPServerListeners::ReusePort).Threads());
+
+  std::mutex mutex;
+  std::set<std::thread::id> thread_ids;
+  const auto scope = http_server.Register("/reuseport", [&mutex, &thread_ids](Request r) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      thread_ids.insert(std::this_thread::get_id());
+    }
+    r(r.url.query["x"] + '\n');
+  });
+  for (int i = 0; i < 40; ++i) {
+    EXPECT_EQ(current::ToString(i) + '\n', HTTP(GET(Printf("http://localhost:%d/reuseport?x=%d", port, i))).body);
+  }
+  // The kernel spreads the connections across the sockets, so forty of them do not all land on one thread.
+  EXPECT_LT(1u, thread_ids.size());
+}
+#endif  // CURRENT_POSIX
+
+TEST(HTTPAPI, KeepAliveAndPipelining) {
+  auto reserved_port = current::net::ReserveLocalPort();
+  const int port = reserved_port;
+  auto& http_server = HTTP(std::move(reserved_port));
+  http_server.SetThreads(2).SetKeepAlive(std::chrono::milliseconds(200), 3u);
+
+  const auto scope = http_server.Register("/echo", [](Request r) { r(r.url.query["s"] + r.body + '\n'); }) +
+                     http_server.Register("/chunks", [](Request r) {
+                       r.connection.SendChunkedHTTPResponse().Send("a\n").Send("b\n");
+                     });
+
+  const auto read_until = [](Connection& connection, const std::string& suffix) {
+    std::string data;
+    char buffer[1024];
+    while (data.length() < suffix.length() || data.substr(data.length() - suffix.length()) != suffix) {
+      data.append(buffer, connection.BlockingRead(buffer, sizeof(buffer)));
+    }
+    return data;
+  };
+  char byte;
+
+  {
+    Connection connection(current::net::ClientSocket("localhost", port));
+    // Two requests, the first one with a body, pipelined in one write, and answered in order.
+    connection.BlockingWrite(
+        "POST /echo?s=one HTTP/1.1\r\nContent-Length: 3\r\n\r\nabcGET /echo?s=two HTTP/1.1\r\nHost: localhost\r\n\r\n",
+        false);
+    const std::string first_two = read_until(connection, "two\n");
+    EXPECT_NE(std::string::npos, first_two.find("Connection: keep-alive"));
+    ASSERT_NE(std::string::npos, first_two.find("oneabc\n"));
+    EXPECT_LT(first_two.find("oneabc\n"), first_two.find("two\n"));
+    // The third request over the same connection is the last one allowed, and the connection is closed after it.
+    connection.BlockingWrite("GET /echo?s=three HTTP/1.1\r\n\r\n", false);
+    EXPECT_NE(std::string::npos, read_until(connection, "three\n").find("Connection: close"));
+    EXPECT_THROW(connection.BlockingRead(&byte, 1u), current::net::SocketException);
+  }
+  {
+    Connection connection(current::net::ClientSocket("localhost", port));
+    connection.BlockingWrite("GET /echo?s=idle HTTP/1.1\r\n\r\n", false);
+    EXPECT_NE(std::string::npos, read_until(connection, "idle\n").find("Connection: keep-alive"));
+    // Nothing else is sent, so the connection is closed once it has been idle for the timeout.
+    EXPECT_THROW(connection.BlockingRead(&byte, 1u), current::net::SocketException);
+  }
+  {
+    Connection connection(current::net::ClientSocket("localhost", port));
+    connection.BlockingWrite("GET /echo?s=bye HTTP/1.1\r\nConnection: close\r\n\r\n", false);
+    EXPECT_NE(std::string::npos, read_until(connection, "bye\n").find("Connection: close"));
+  }
+  {
+    Connection connection(current::net::ClientSocket("localhost", port));
+    connection.BlockingWrite("GET /echo?s=old HTTP/1.0\r\n\r\n", false);
+    EXPECT_NE(std::string::npos, read_until(connection, "old\n").find("Connection: close"));
+  }
+
+  // The chunked responses, as well as the regular client, are not affected.
+  EXPECT_EQ("a\nb\n", HTTP(GET(Printf("http://localhost:%d/chunks", port))).body);
+  EXPECT_EQ("x\n", HTTP(GET(Printf("http://localhost:%d/echo?s=x", port))).body);
+  http_server.DisableKeepAlive();
+}
+
+TEST(HTTPAPI, ClientConnectionPool) {
+  auto& pool = current::http::HTTPClientConnectionPool();
+  // Drop the connections pooled by the tests above.
+  pool.Disable();
+  pool.SetLimits(current::http::HTTPClientPOSIXConnectionPool::kDefaultMaxIdlePerHost,
+                 current::http::HTTPClientPOSIXConnectionPool::kDefaultIdleTimeout);
+
+  auto reserved_port = current::net::ReserveLocalPort();
+  const int port = reserved_port;
+  auto& http_server = HTTP(std::move(reserved_port));
+  http_server.SetThreads(2).SetKeepAlive(std::chrono::milliseconds(100));
+
+  // Respond with the port of the client, which stays the same as long as the connection is reused.
+  const auto scope = http_server.Register(
+      "/port", [](Request r) { r(current::ToString(r.connection.RemoteIPAndPort().port) + r.body); });
+  const std::string url = Printf("http://localhost:%d/port", port);
+
+  const std::string first = HTTP(GET(url)).body;
+  EXPECT_EQ(1u, pool.IdleConnections());
+  EXPECT_EQ(first, HTTP(GET(url)).body);
+  EXPECT_EQ(first + "body", HTTP(POST(url, "body")).body);
+  EXPECT_EQ(1u, pool.IdleConnections());
+
+  // Per request, the pool can be bypassed.
+  EXPECT_NE(first, HTTP(GET(url).KeepAlive(false)).body);
+  EXPECT_EQ(1u, pool.IdleConnections());
+
+  // Once the server has closed the idle connection, it is not reused, and the request goes over a new one.
+  std::this_thread::sleep_for(std::chrono::milliseconds(250));
+  const std::string second = HTTP(POST(url, "")).body;
+  EXPECT_NE(first, second);
+  EXPECT_EQ(1u, pool.IdleConnections());
+
+  // For the whole binary, the pool can be turned off.
+  pool.Disable();
+  EXPECT_EQ(0u, pool.IdleConnections());
+  EXPECT_NE(second, HTTP(GET(url)).body);
+  EXPECT_EQ(0u, pool.IdleConnections());
+
+  pool.SetLimits(current::http::HTTPClientPOSIXConnectionPool::kDefaultMaxIdlePerHost,
+                 current::http::HTTPClientPOSIXConnectionPool::kDefaultIdleTimeout);
+  http_server.DisableKeepAlive();
+}
+
+#ifdef CURRENT_POSIX
+TEST(HTTPAPI, AsyncClient) {
+  auto reserved_port = current::net::ReserveLocalPort();
+  const int port = reserved_port;
+  auto& http_server = HTTP(std::move(reserved_port));
+  http_server.SetThreads(4).SetKeepAlive(std::chrono::seconds(10));
+
+  std::atomic_bool release_slow(false);
+  const auto scope =
+      http_server.Register("/echo", [](Request r) { r(r.url.query["s"] + r.body); }) +
+      http_server.Register("/chunked",
+                           [](Request r) {
+                             auto response = r.SendChunkedResponse();
+                             response("foo");
+                             response("bar");
+                           }) +
+      http_server.Register("/slow", [&release_slow](Request r) {
+        while (!release_slow) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        r("slow");
+      });
+  const std::string base_url = Printf("http://localhost:%d", port);
+
+  // Many requests in flight at once, from a single thread, over as many connections as the per-host limit allows.
+  {
+    current::http::HTTPAsyncClientPOSIX client(8u);
+    std::vector<std::future<current::http::HTTPResponseWithBuffer>> responses;
+    for (size_t i = 0u; i < 1000u; ++i) {
+      responses.push_back(client(GET(base_url + "/echo?s=" + current::ToString(i))));
+    }
+    for (size_t i = 0u; i < responses.size(); ++i) {
+      const auto response = responses[i].get();
+      EXPECT_EQ(200, static_cast<int>(response.code));
+      EXPECT_EQ(current::ToString(i), response.body);
+    }
+    EXPECT_EQ(0u, client.InFlight());
+
+    // The callbacks, the request bodies, and the chunked responses.
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> bodies;
+    for (size_t i = 0u; i < 10u; ++i) {
+      client(POST(base_url + "/echo?s=" + current::ToString(i), "+posted"),
+             [&](current::http::HTTPResponseWithBuffer response) {
+               std::lock_guard<std::mutex> lock(mutex);
+               bodies.push_back(response.body);
+               cv.notify_one();
+             },
+             [](std::exception_ptr) { ASSERT_TRUE(false); });
+    }
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [&bodies]() { return bodies.size() == 10u; });
+    }
+    std::sort(bodies.begin(), bodies.end());
+    EXPECT_EQ("0+posted", bodies.front());
+    EXPECT_EQ("9+posted", bodies.back());
+    EXPECT_EQ("foobar", client(GET(base_url + "/chunked")).get().body);
+  }
+
+  // Past the per-host limit, the requests are queued, and each fails once its timeout has passed.
+  {
+    current::http::HTTPAsyncClientPOSIX client(2u);
+    std::vector<std::future<current::http::HTTPResponseWithBuffer>> slow;
+    for (size_t i = 0u; i < 2u; ++i) {
+      slow.push_back(client(GET(base_url + "/slow")));
+    }
+    auto timed_out = client(GET(base_url + "/echo?s=never"), std::chrono::milliseconds(50));
+    EXPECT_EQ(2u, client.InFlight());
+    EXPECT_EQ(1u, client.Queued());
+    EXPECT_THROW(timed_out.get(), current::net::HTTPTimeoutException);
+    release_slow = true;
+    for (auto& response : slow) {
+      EXPECT_EQ("slow", response.get().body);
+    }
+    EXPECT_EQ(0u, client.InFlight());
+    EXPECT_EQ(0u, client.Queued());
+  }
+
+  // The errors are reported via the futures as well.
+  {
+    current::http::HTTPAsyncClientPOSIX client;
+    const int closed_port = current::net::ReserveLocalPort();
+    EXPECT_THROW(client(GET(Printf("http://localhost:%d/", closed_port))).get(),
+                 current::net::SocketConnectException);
+  }
+
+  http_server.DisableKeepAlive();
+}
+#endif  // CURRENT_POSIX
+
+#ifdef CURRENT_POSIX
+TEST(HTTPAPI, IdleConnectionsAndSubscribersCostNoThreads) {
+  auto reserved_port = current::net::ReserveLocalPort();
+  const int port = reserved_port;
+  auto& http_server = HTTP(std::move(reserved_port));
+  http_server.SetKeepAlive(std::chrono::seconds(10));
+
+  std::mutex mutex;
+  std::vector<current::net::ReactorChunkedResponseSender> subscribers;
+  const auto scope =
+      http_server.Register("/echo", [](Request r) { r(r.url.query["s"] + '\n'); }) +
+      http_server.Register("/subscribe", [&mutex, &subscribers](Request r) {
+        auto sender = r.SendChunkedResponseViaReactor();
+        std::lock_guard<std::mutex> lock(mutex);
+        subscribers.push_back(std::move(sender));
+      });
+
+  const auto read_until = [](Connection& connection, const std::string& suffix) {
+    std::string data;
+    char buffer[1024];
+    while (data.length() < suffix.length() || data.substr(data.length() - suffix.length()) != suffix) {
+      data.append(buffer, connection.BlockingRead(buffer, sizeof(buffer)));
+    }
+    return data;
+  };
+
+  // With a single serving thread, the kept alive connections left idle do not hold back the other clients,
+  // and are served again once their clients send more requests.
+  std::vector<std::unique_ptr<Connection>> idle;
+  for (size_t i = 0u; i < 100u; ++i) {
+    idle.push_back(std::make_unique<Connection>(current::net::ClientSocket("localhost", port)));
+    idle.back()->BlockingWrite(Printf("GET /echo?s=first%d HTTP/1.1\r\n\r\n", static_cast<int>(i)), false);
+    read_until(*idle.back(), Printf("first%d\n", static_cast<int>(i)));
+  }
+  for (size_t i = 0u; i < idle.size(); ++i) {
+    idle[i]->BlockingWrite(Printf("GET /echo?s=second%d HTTP/1.1\r\n\r\n", static_cast<int>(i)), false);
+    read_until(*idle[i], Printf("second%d\n", static_cast<int>(i)));
+  }
+  EXPECT_EQ(1u, http_server.Threads());
+
+  // The subscribers are streamed to via the reactor, from whichever thread, after their handlers have returned.
+  std::vector<std::unique_ptr<Connection>> clients;
+  for (size_t i = 0u; i < 10u; ++i) {
+    clients.push_back(std::make_unique<Connection>(current::net::ClientSocket("localhost", port)));
+    clients.back()->BlockingWrite("GET /subscribe HTTP/1.1\r\n\r\n", false);
+  }
+  while (true) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (subscribers.size() == clients.size()) {
+      break;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& subscriber : subscribers) {
+      subscriber.Send("update\n");
+    }
+    subscribers.clear();
+  }
+  for (auto& client : clients) {
+    const std::string response = read_until(*client, "0\r\n\r\n");
+    EXPECT_NE(std::string::npos, response.find("Transfer-Encoding: chunked"));
+    EXPECT_NE(std::string::npos, response.find("7\r\nupdate\n\r\n0\r\n\r\n"));
+    char byte;
+    EXPECT_THROW(client->BlockingRead(&byte, 1u), current::net::SocketException);
+  }
+  http_server.DisableKeepAlive();
+}
+#endif  // CURRENT_POSIX
@@ -59,6 +59,7 @@ struct HTTPRequestBase {
   std::string custom_user_agent = "";
   current::net::http::Headers custom_headers;
   bool allow_redirects = false;
+  bool keep_alive = true;
 
   HTTPRequestBase(const std::string& url) : url(url) {}
 
@@ -72,6 +73,12 @@ struct HTTPRequestBase {
     return static_cast<T&>(*this);
   }
 
+  // Whether the connection may be taken from, and returned to, the pool of the client, if the client has one.
+  T& KeepAlive(bool keep_alive_setting = true) {
+    keep_alive = keep_alive_setting;
+    return static_cast<T&>(*this);
+  }
+
   T& SetHeader(const std::string& key, const std::string& value) {
     custom_headers.emplace_back(key, value);
     return static_cast<T&>(*this);
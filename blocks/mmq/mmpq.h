@@ -26,12 +26,17 @@ SOFTWARE.
 #define BLOCKS_MMQ_MMPQ_H
 
 // MMPQ is an in-memory priority queue, with the external interface loosely resembling the one of the original MMQ.
+//
+// The pending messages are kept in a `RadixHeap`, see "radix_heap.h", ordered by their timestamps, and then by indexes.
+// Once warmed up, it does not allocate memory per message, and scheduling far into the future is as cheap as into
+// the near future. The consumer is called with the mutex released, so publishers are not blocked by it.
 
 #include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <thread>
-#include <set>
+
+#include "radix_heap.h"
 
 #include "../ss/ss.h"
 
@@ -80,7 +85,8 @@ class MMPQImpl {
     // Does not update `last_idx_ts_.us` at all. `UpdateHead()` must be called.
     // This is to ensure the regular `Publish`, coming through the interface defined in `Blocks/ss/pubsub.h`,
     // can publish into the future and utilize the full power of MMPQ.
-    queue_.emplace(std::forward<E>(entry), idxts_t(last_idx_ts_.index, us));
+    queue_.Push(
+        KeyFromTimestamp(us), last_idx_ts_.index, Entry(std::forward<E>(entry), idxts_t(last_idx_ts_.index, us)));
     condition_variable_.notify_all();
     return last_idx_ts_;
   }
@@ -104,21 +110,34 @@ class MMPQImpl {
   void operator=(const MMPQImpl&) = delete;
   void operator=(MMPQImpl&&) = delete;
 
+  // The radix heap orders unsigned keys; timestamps before the epoch, if any, are treated as the epoch.
+  static uint64_t KeyFromTimestamp(std::chrono::microseconds us) {
+    return us.count() > 0 ? static_cast<uint64_t>(us.count()) : 0u;
+  }
+
   void ConsumerThread() {
+    Entry entry;
+    idxts_t save_last_idx_ts;
     while (true) {
-      std::unique_lock<std::mutex> lock(mutex_);
+      {
+        // MUTEX-LOCKED, except for the condition variable part.
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        condition_variable_.wait(lock, [this] {
+          return (!queue_.Empty() && queue_.Top().index_timestamp.us <= last_idx_ts_.us) || destructing_;
+        });
 
-      condition_variable_.wait(lock, [this] {
-        return (!queue_.empty() && queue_.begin()->index_timestamp.us <= last_idx_ts_.us) || destructing_;
-      });
+        if (destructing_) {
+          return;  // LCOV_EXCL_LINE
+        }
 
-      if (destructing_) {
-        return;  // LCOV_EXCL_LINE
+        entry = std::move(queue_.Top());
+        queue_.Pop();
+        save_last_idx_ts = last_idx_ts_;
       }
 
-      auto it = queue_.begin();
-      consumer_(std::move(const_cast<Entry&>(*it).message_body), it->index_timestamp, last_idx_ts_);
-      queue_.erase(it);
+      // NO MUTEX REQUIRED.
+      consumer_(std::move(entry.message_body), entry.index_timestamp, save_last_idx_ts);
     }
   }
 
@@ -133,12 +152,12 @@ class MMPQImpl {
     message_t message_body;
     Entry() = default;
     Entry(Entry&&) = default;
+    Entry& operator=(Entry&&) = default;
     Entry(message_t&& message_body, idxts_t index_timestamp)
         : index_timestamp(index_timestamp), message_body(std::move(message_body)) {}
-    bool operator<(const Entry& rhs) const { return index_timestamp.us < rhs.index_timestamp.us; }
   };
 
-  std::set<Entry> queue_;
+  RadixHeap<Entry> queue_;
   idxts_t last_idx_ts_ = idxts_t(0, std::chrono::microseconds(-1));
   std::mutex mutex_;
   std::condition_variable condition_variable_;
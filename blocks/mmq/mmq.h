@@ -45,7 +45,17 @@ SOFTWARE.
 //      the messages will be added in the order in which the functions were called. However, for any particular
 //      thread, MMQ DOES GUARANTEE that the order of messages published from this thread will be respected.
 //  Default behavior of MMQ is non-dropping and can be controlled via the `DROP_ON_OVERFLOW` template argument.
+//
+// Alternatively, the consumer may opt in to receive messages in batches. A consumer which is not an `EntrySubscriber`,
+// but is callable as `consumer(MMQBatch<MESSAGE>&)`, is handed everything that is ready to be exported at once,
+// as one or two contiguous spans of the circular buffer (two if the batch wraps around its end), along with the number
+// of messages dropped since the previous batch. The slots of the batch are released in one step once it returns.
+//
+// The way the consumer thread and the blocked publishers wait is defined by the `WAIT_POLICY` template argument,
+// see "bricks/sync/wait_policy.h". Spinning or busy-polling cuts the publish-to-consumer latency on hot paths.
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <mutex>
@@ -56,21 +66,84 @@ SOFTWARE.
 
 #include "../ss/ss.h"
 
+#include "../../bricks/sync/wait_policy.h"
 #include "../../bricks/time/chrono.h"
 
 namespace current {
 namespace mmq {
 
-template <typename MESSAGE, typename CONSUMER, size_t DEFAULT_BUFFER_SIZE = 1024, bool DROP_ON_OVERFLOW = false>
+// The `MMQEntry` struct keeps the entries along with their timestamps and completion status.
+template <typename MESSAGE>
+struct MMQEntry {
+  idxts_t index_timestamp;
+  MESSAGE message_body;
+  enum { FREE, BEING_IMPORTED, READY, BEING_EXPORTED } status = MMQEntry::FREE;
+};
+
+// A contiguous range of the entries of the circular buffer, all of them `BEING_EXPORTED`.
+template <typename MESSAGE>
+class MMQSpan {
+ public:
+  using entry_t = MMQEntry<MESSAGE>;
+
+  MMQSpan() = default;
+  MMQSpan(entry_t* begin, size_t size) : begin_(begin), size_(size) {}
+
+  entry_t* begin() const { return begin_; }
+  entry_t* end() const { return begin_ + size_; }
+  size_t size() const { return size_; }
+  bool empty() const { return !size_; }
+  entry_t& operator[](size_t i) const { return begin_[i]; }
+
+ private:
+  entry_t* begin_ = nullptr;
+  size_t size_ = 0u;
+};
+
+// The unit of work for batch consumers. The entries are owned by the queue, and only valid until the consumer returns,
+// although the consumer is free to move the message bodies out of them.
+template <typename MESSAGE>
+struct MMQBatch {
+  MMQSpan<MESSAGE> first;   // From the tail of the circular buffer up to, at most, its physical end.
+  MMQSpan<MESSAGE> second;  // The part that has wrapped around to the beginning of the buffer, possibly empty.
+  uint64_t dropped = 0u;    // The number of messages dropped on overflow since the previous batch.
+  idxts_t last;             // The index and timestamp of the last message accepted by the queue.
+
+  size_t size() const { return first.size() + second.size(); }
+  template <typename F>
+  void ForEach(F&& f) const {
+    for (auto& e : first) {
+      f(e);
+    }
+    for (auto& e : second) {
+      f(e);
+    }
+  }
+};
+
+// For `static_assert`-s. A batch consumer is the one that accepts `MMQBatch<MESSAGE>&` and is not an entry subscriber.
+template <typename CONSUMER, typename MESSAGE>
+struct IsBatchConsumer {
+  static constexpr bool value = !current::ss::IsEntrySubscriber<CONSUMER, MESSAGE>::value &&
+                                std::is_invocable<CONSUMER&, MMQBatch<MESSAGE>&>::value;
+};
+
+template <typename MESSAGE,
+          typename CONSUMER,
+          size_t DEFAULT_BUFFER_SIZE = 1024,
+          bool DROP_ON_OVERFLOW = false,
+          typename WAIT_POLICY = current::locks::BlockingWaitPolicy>
 class MMQImpl {
-  static_assert(current::ss::IsEntrySubscriber<CONSUMER, MESSAGE>::value, "");
+  static_assert(current::ss::IsEntrySubscriber<CONSUMER, MESSAGE>::value || IsBatchConsumer<CONSUMER, MESSAGE>::value,
+                "");
 
  public:
   // The type of messages to store and dispatch.
   using message_t = MESSAGE;
 
   // Consumer's `operator()` will be called from a dedicated thread, which is spawned and owned
-  // by the instance of MMQImpl. See "blocks/ss/ss.h" and its test for possible callee signatures.
+  // by the instance of MMQImpl. See "blocks/ss/ss.h" and its test for possible callee signatures,
+  // and `MMQBatch` above for the batch one.
   using consumer_t = CONSUMER;
 
   MMQImpl(consumer_t& consumer, size_t buffer_size = DEFAULT_BUFFER_SIZE)
@@ -88,7 +161,7 @@ class MMQImpl {
       {
         std::lock_guard<std::mutex> lock(mutex_);
         destructing_ = true;
-        condition_variable_.notify_all();
+        Notify();
       }
       consumer_thread_.join();
     }
@@ -128,11 +201,34 @@ class MMQImpl {
   void operator=(const MMQImpl&) = delete;
   void operator=(MMQImpl&&) = delete;
 
+  // Waits until `predicate()` is true, as per `WAIT_POLICY`. The lock is released while waiting.
+  template <typename F>
+  void Wait(std::unique_lock<std::mutex>& lock, F&& predicate) {
+    WAIT_POLICY::Wait(lock,
+                      predicate,
+                      [this]() { return events_.load(std::memory_order_acquire); },
+                      [this, &lock, &predicate]() { condition_variable_.wait(lock, predicate); });
+  }
+
+  // Wakes up the waiting threads, blocked or spinning. To be called after the state they are waiting on has changed.
+  void Notify(bool all = true) {
+    events_.fetch_add(1u, std::memory_order_release);
+    if (all) {
+      condition_variable_.notify_all();
+    } else {
+      condition_variable_.notify_one();
+    }
+  }
+
   // Increment the index respecting the circular nature of the buffer.
   void Increment(size_t& i) const { i = (i + 1) % circular_buffer_size_; }
 
   // The thread which extracts fully populated messages from the tail of the buffer and feeds them to the consumer.
   void ConsumerThread() {
+    ConsumerThreadImpl(std::integral_constant<bool, IsBatchConsumer<CONSUMER, MESSAGE>::value>());
+  }
+
+  void ConsumerThreadImpl(std::false_type) {
     // The `tail` pointer is local to the procesing thread.
     size_t tail = 0u;
     idxts_t save_last_idx_ts;
@@ -142,8 +238,7 @@ class MMQImpl {
         // Get the next message, which is `READY` to be exported.
         // MUTEX-LOCKED, except for the condition variable part.
         std::unique_lock<std::mutex> lock(mutex_);
-        condition_variable_.wait(
-            lock, [this, tail] { return (circular_buffer_[tail].status == Entry::READY) || destructing_; });
+        Wait(lock, [this, tail] { return (circular_buffer_[tail].status == Entry::READY) || destructing_; });
         if (destructing_) {
           return;  // LCOV_EXCL_LINE
         }
@@ -169,7 +264,59 @@ class MMQImpl {
 
         // Need to notify message publishers that, in case they were waiting, a new slot is now available.
         // TODO(dkorolev) + TODO(mzhurovich): Think whether this might be a performance bottleneck.
-        condition_variable_.notify_one();
+        Notify(false);
+      }
+    }
+  }
+
+  // The batch version of the consumer thread: grabs all the `READY` messages at once, and frees them all at once.
+  void ConsumerThreadImpl(std::true_type) {
+    size_t tail = 0u;
+
+    while (true) {
+      MMQBatch<message_t> batch;
+      size_t count = 0u;
+
+      {
+        // Mark the whole contiguous run of `READY` messages, starting from the tail, as `BEING_EXPORTED`.
+        // MUTEX-LOCKED, except for the condition variable part.
+        std::unique_lock<std::mutex> lock(mutex_);
+        Wait(lock, [this, tail] { return (circular_buffer_[tail].status == Entry::READY) || destructing_; });
+        if (destructing_) {
+          return;  // LCOV_EXCL_LINE
+        }
+        for (size_t i = tail; count < circular_buffer_size_ && circular_buffer_[i].status == Entry::READY;
+             Increment(i)) {
+          circular_buffer_[i].status = Entry::BEING_EXPORTED;
+          ++count;
+        }
+        batch.dropped = dropped_;
+        dropped_ = 0u;
+        batch.last = last_idx_ts_;
+      }
+
+      {
+        // Then, export the batch.
+        // NO MUTEX REQUIRED.
+        const size_t first_size = std::min(count, circular_buffer_size_ - tail);
+        batch.first = MMQSpan<message_t>(&circular_buffer_[tail], first_size);
+        batch.second = MMQSpan<message_t>(&circular_buffer_[0], count - first_size);
+        consumer_(batch);
+      }
+
+      {
+        // Finally, release all the slots of the batch in one step.
+        // MUTEX-LOCKED.
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          for (size_t i = 0; i < count; ++i) {
+            circular_buffer_[tail].status = Entry::FREE;
+            Increment(tail);
+          }
+        }
+
+        // More than one slot may have been freed, so more than one publisher may proceed.
+        Notify();
       }
     }
   }
@@ -196,6 +343,7 @@ class MMQImpl {
       return std::make_pair(true, index);
     } else {
       // Overflow. Discarding the message.
+      ++dropped_;
       return std::make_pair(false, 0u);
     }
   }
@@ -218,8 +366,7 @@ class MMQImpl {
     }
     while (circular_buffer_[head_].status != Entry::FREE) {
       // Waiting for the next empty slot in the buffer.
-      condition_variable_.wait(lock,
-                               [this] { return (circular_buffer_[head_].status == Entry::FREE) || destructing_; });
+      Wait(lock, [this] { return (circular_buffer_[head_].status == Entry::FREE) || destructing_; });
       if (destructing_) {
         return std::make_pair(false, 0u);  // LCOV_EXCL_LINE
       }
@@ -238,7 +385,7 @@ class MMQImpl {
     // MUTEX-LOCKED.
     std::lock_guard<std::mutex> lock(mutex_);
     circular_buffer_[index].status = Entry::READY;
-    condition_variable_.notify_all();
+    Notify();
   }
 
   bool consumer_thread_created_ = false;
@@ -250,12 +397,7 @@ class MMQImpl {
   // Messages beyond it will be dropped.
   const size_t circular_buffer_size_;
 
-  // The `Entry` struct keeps the entries along with their timestamps and completion status.
-  struct Entry {
-    idxts_t index_timestamp;
-    message_t message_body;
-    enum { FREE, BEING_IMPORTED, READY, BEING_EXPORTED } status = Entry::FREE;
-  };
+  using Entry = MMQEntry<message_t>;
 
   // The circular buffer, of size `circular_buffer_size_`.
   // Entries are added/imported at `head_` and removed/exported at `tail`,
@@ -264,8 +406,13 @@ class MMQImpl {
   size_t head_ = 0u;
   std::mutex mutex_;
   std::condition_variable condition_variable_;
+  std::atomic<uint64_t> events_{0u};  // Bumped on every notification, for the spinning `WAIT_POLICY`-s to watch.
   idxts_t last_idx_ts_ = idxts_t(0, std::chrono::microseconds(-1));
 
+  // The number of messages dropped on overflow since the last batch was handed to the consumer. Counted for every
+  // consumer when `DROP_ON_OVERFLOW` is set, but only reported, and reset, by batch consumers.
+  uint64_t dropped_ = 0u;
+
   // For safe thread destruction.
   bool destructing_ = false;
 
@@ -273,8 +420,12 @@ class MMQImpl {
   std::thread consumer_thread_;
 };
 
-template <typename MESSAGE, typename CONSUMER, size_t DEFAULT_BUFFER_SIZE = 1024, bool DROP_ON_OVERFLOW = false>
-using MMQ = ss::EntryPublisher<MMQImpl<MESSAGE, CONSUMER, DEFAULT_BUFFER_SIZE, DROP_ON_OVERFLOW>, MESSAGE>;
+template <typename MESSAGE,
+          typename CONSUMER,
+          size_t DEFAULT_BUFFER_SIZE = 1024,
+          bool DROP_ON_OVERFLOW = false,
+          typename WAIT_POLICY = current::locks::BlockingWaitPolicy>
+using MMQ = ss::EntryPublisher<MMQImpl<MESSAGE, CONSUMER, DEFAULT_BUFFER_SIZE, DROP_ON_OVERFLOW, WAIT_POLICY>, MESSAGE>;
 
 }  // namespace mmq
 }  // namespace current
@@ -0,0 +1,272 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2026 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#ifndef BLOCKS_MMQ_PARALLEL_MMQ_H
+#define BLOCKS_MMQ_PARALLEL_MMQ_H
+
+// Parallel MMQ is the MMQ with N consumer threads, each owning its own circular buffer.
+//
+// Each message is routed to a worker by its key, as returned by the `KEY_EXTRACTOR` functor, which is
+// default-constructed and called as `key_extractor(message)`. The key must be hashable with `std::hash<>`.
+// Messages with the same key are always processed by the same worker, and thus in the order of publishing,
+// while messages with different keys are processed in parallel.
+//
+// The consumer is shared across the workers, and its `operator()` is called concurrently from all of them,
+// so it must be thread safe. The `current` index and timestamp passed to it are global across the queue, while
+// `last` is the index and timestamp of the last message accepted into the queue of this particular worker.
+//
+// The `buffer_size` is per worker, so the queue holds at most `workers * buffer_size` messages. The overflow policies
+// are the same as in MMQ, and apply per worker: a full queue of one worker does not affect the others.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "mmq.h"
+
+namespace current {
+namespace mmq {
+
+template <typename MESSAGE,
+          typename CONSUMER,
+          typename KEY_EXTRACTOR,
+          size_t DEFAULT_BUFFER_SIZE = 1024,
+          bool DROP_ON_OVERFLOW = false>
+class ParallelMMQImpl {
+  static_assert(current::ss::IsEntrySubscriber<CONSUMER, MESSAGE>::value, "");
+
+ public:
+  using message_t = MESSAGE;
+  using consumer_t = CONSUMER;
+  using key_extractor_t = KEY_EXTRACTOR;
+
+  ParallelMMQImpl(consumer_t& consumer,
+                  size_t workers = std::thread::hardware_concurrency(),
+                  size_t buffer_size = DEFAULT_BUFFER_SIZE)
+      : consumer_(consumer) {
+    workers_.resize(std::max(workers, static_cast<size_t>(1u)));
+    for (auto& worker : workers_) {
+      worker = std::make_unique<Worker>(buffer_size);
+    }
+    for (auto& worker : workers_) {
+      worker->thread = std::thread(&ParallelMMQImpl::ConsumerThread, this, std::ref(*worker));
+    }
+  }
+
+  // The destructor waits for all the consumer threads to terminate.
+  ~ParallelMMQImpl() {
+    for (auto& worker : workers_) {
+      std::lock_guard<std::mutex> lock(worker->mutex);
+      worker->destructing = true;
+      worker->condition_variable.notify_all();
+    }
+    for (auto& worker : workers_) {
+      CURRENT_ASSERT(worker->thread.joinable());
+      worker->thread.join();
+    }
+  }
+
+  size_t WorkersCount() const { return workers_.size(); }
+
+ protected:
+  // Adds a message to the buffer of the worker responsible for its key. Supports both copy and move semantics.
+  // THREAD SAFE. Only the publishers to the same worker contend for its lock; the global lock is held just
+  // for the duration of assigning the index and timestamp.
+  template <current::locks::MutexLockStatus, typename E, typename TIMESTAMP>  // `MutexLockStatus` is unused.
+  idxts_t PublisherPublishImpl(E&& message, TIMESTAMP&& timestamp) {
+    Worker& worker = *workers_[WorkerIndex(message)];
+    const std::pair<bool, size_t> index = CircularBufferAllocate(worker, std::forward<TIMESTAMP>(timestamp));
+    if (index.first) {
+      Entry& entry = worker.circular_buffer[index.second];
+      entry.message_body = std::forward<E>(message);
+      {
+        // After the message has been copied over, mark it as `READY` for consumer.
+        // MUTEX-LOCKED.
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        entry.status = Entry::READY;
+        worker.condition_variable.notify_all();
+      }
+      return entry.index_timestamp;
+    } else {
+      return idxts_t();
+    }
+  }
+
+ private:
+  ParallelMMQImpl(const ParallelMMQImpl&) = delete;
+  ParallelMMQImpl(ParallelMMQImpl&&) = delete;
+  void operator=(const ParallelMMQImpl&) = delete;
+  void operator=(ParallelMMQImpl&&) = delete;
+
+  using Entry = MMQEntry<message_t>;
+
+  // The per-worker part of the queue: the circular buffer, its lock, and the consumer thread.
+  struct Worker {
+    const size_t circular_buffer_size;
+    std::vector<Entry> circular_buffer;
+    size_t head = 0u;
+    std::mutex mutex;
+    std::condition_variable condition_variable;
+    idxts_t last_idx_ts = idxts_t(0, std::chrono::microseconds(-1));
+    bool destructing = false;
+    std::thread thread;
+
+    explicit Worker(size_t buffer_size)
+        : circular_buffer_size(std::max(buffer_size, static_cast<size_t>(1u))),
+          circular_buffer(circular_buffer_size) {}
+
+    void Increment(size_t& i) const { i = (i + 1) % circular_buffer_size; }
+  };
+
+  size_t WorkerIndex(const message_t& message) const {
+    const auto key = key_extractor_(message);
+    return std::hash<current::decay_t<decltype(key)>>()(key) % workers_.size();
+  }
+
+  // Assigns the next global index and timestamp. Must be called with the lock of the worker held,
+  // which guarantees the messages of each worker are placed into its buffer in the order of their indexes.
+  template <typename TIMESTAMP>
+  idxts_t NextIndexTimestamp(const TIMESTAMP user_timestamp) {
+    // MUTEX-LOCKED, the global mutex.
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto timestamp = current::time::TimestampAsMicroseconds(user_timestamp);
+    if (!(timestamp > last_idx_ts_.us)) {
+      CURRENT_THROW(ss::InconsistentTimestampException(last_idx_ts_.us + std::chrono::microseconds(1), timestamp));
+    }
+    ++last_idx_ts_.index;
+    last_idx_ts_.us = timestamp;
+    return last_idx_ts_;
+  }
+
+  // Returns { successful allocation flag, circular buffer index }.
+  template <bool DROP = DROP_ON_OVERFLOW, typename TIMESTAMP>
+  std::enable_if_t<DROP && time::IsTimestamp<TIMESTAMP>::value, std::pair<bool, size_t>> CircularBufferAllocate(
+      Worker& worker, const TIMESTAMP user_timestamp) {
+    // Implementation that discards the message if the queue of its worker is full.
+    // MUTEX-LOCKED, the mutex of the worker.
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.circular_buffer[worker.head].status == Entry::FREE) {
+      return CircularBufferAllocateLocked(worker, user_timestamp);
+    } else {
+      // Overflow. Discarding the message.
+      return std::make_pair(false, 0u);
+    }
+  }
+
+  // Returns { successful allocation flag, circular buffer index }.
+  template <bool DROP = DROP_ON_OVERFLOW,
+            typename TIMESTAMP,
+            class = std::enable_if_t<time::IsTimestamp<TIMESTAMP>::value>>
+  std::enable_if_t<!DROP, std::pair<bool, size_t>> CircularBufferAllocate(Worker& worker,
+                                                                          const TIMESTAMP user_timestamp) {
+    // Implementation that waits for an empty space if the queue of its worker is full.
+    // MUTEX-LOCKED, the mutex of the worker.
+    std::unique_lock<std::mutex> lock(worker.mutex);
+    worker.condition_variable.wait(lock, [&worker] {
+      return (worker.circular_buffer[worker.head].status == Entry::FREE) || worker.destructing;
+    });
+    if (worker.destructing) {
+      return std::make_pair(false, 0u);  // LCOV_EXCL_LINE
+    }
+    return CircularBufferAllocateLocked(worker, user_timestamp);
+  }
+
+  template <typename TIMESTAMP>
+  std::pair<bool, size_t> CircularBufferAllocateLocked(Worker& worker, const TIMESTAMP user_timestamp) {
+    const size_t index = worker.head;
+    worker.last_idx_ts = NextIndexTimestamp(user_timestamp);
+    worker.Increment(worker.head);
+    worker.circular_buffer[index].status = Entry::BEING_IMPORTED;
+    worker.circular_buffer[index].index_timestamp = worker.last_idx_ts;
+    return std::make_pair(true, index);
+  }
+
+  // The thread of each worker, which feeds the messages from the tail of its buffer to the consumer.
+  void ConsumerThread(Worker& worker) {
+    size_t tail = 0u;
+    idxts_t save_last_idx_ts;
+
+    while (true) {
+      {
+        // MUTEX-LOCKED, except for the condition variable part.
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        worker.condition_variable.wait(lock, [&worker, tail] {
+          return (worker.circular_buffer[tail].status == Entry::READY) || worker.destructing;
+        });
+        if (worker.destructing) {
+          return;  // LCOV_EXCL_LINE
+        }
+        worker.circular_buffer[tail].status = Entry::BEING_EXPORTED;
+        save_last_idx_ts = worker.last_idx_ts;
+      }
+
+      {
+        // NO MUTEX REQUIRED.
+        Entry& entry = worker.circular_buffer[tail];
+        consumer_(std::move(entry.message_body), entry.index_timestamp, save_last_idx_ts);
+      }
+
+      {
+        // MUTEX-LOCKED.
+        {
+          std::lock_guard<std::mutex> lock(worker.mutex);
+          worker.circular_buffer[tail].status = Entry::FREE;
+        }
+        worker.Increment(tail);
+        worker.condition_variable.notify_all();
+      }
+    }
+  }
+
+  // The instance of the consuming side, shared by all the workers.
+  consumer_t& consumer_;
+
+  const key_extractor_t key_extractor_ = key_extractor_t();
+
+  // The global index and timestamp, guarded by `mutex_`. The lock order is always the worker's mutex first.
+  std::mutex mutex_;
+  idxts_t last_idx_ts_ = idxts_t(0, std::chrono::microseconds(-1));
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+template <typename MESSAGE,
+          typename CONSUMER,
+          typename KEY_EXTRACTOR,
+          size_t DEFAULT_BUFFER_SIZE = 1024,
+          bool DROP_ON_OVERFLOW = false>
+using ParallelMMQ =
+    ss::EntryPublisher<ParallelMMQImpl<MESSAGE, CONSUMER, KEY_EXTRACTOR, DEFAULT_BUFFER_SIZE, DROP_ON_OVERFLOW>,
+                       MESSAGE>;
+
+}  // namespace mmq
+}  // namespace current
+
+#endif  // BLOCKS_MMQ_PARALLEL_MMQ_H
@@ -0,0 +1,168 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2026 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#ifndef BLOCKS_MMQ_RADIX_HEAP_H
+#define BLOCKS_MMQ_RADIX_HEAP_H
+
+// `RadixHeap` is the monotone priority queue backing MMPQ.
+//
+// The keys are the 64-bit timestamps. The heap keeps 65 buckets, where the bucket `i > 0` holds the items whose key
+// differs from the last extracted minimum in the bit `i - 1` as the most significant one, and bucket zero holds
+// the items with the key equal to the last extracted minimum. Thus pushing is O(1), and each item is moved between
+// the buckets at most 64 times over its lifetime, only ever towards bucket zero, regardless of how far into the future
+// it is scheduled.
+//
+// Items with the same key are extracted in the order of their `sequence` numbers. Items pushed with the key smaller
+// than the last extracted one, i.e. "into the past", are placed into bucket zero and extracted right away.
+// Bucket zero is kept as a binary heap of its own, so that such pushes cost O(log n) of its size, not O(n).
+//
+// The values themselves live in a slab of reusable slots, and the buckets only keep the slot indexes, so that,
+// once the heap has warmed up, neither pushing nor popping allocates memory.
+
+#include "../../port.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace current {
+namespace mmq {
+
+template <typename T>
+class RadixHeap {
+ public:
+  bool Empty() const { return !size_; }
+  size_t Size() const { return size_; }
+
+  template <typename E>
+  void Push(uint64_t key, uint64_t sequence, E&& value) {
+    uint32_t slot;
+    if (!free_slots_.empty()) {
+      slot = free_slots_.back();
+      free_slots_.pop_back();
+      slab_[slot] = std::forward<E>(value);
+    } else {
+      slot = static_cast<uint32_t>(slab_.size());
+      slab_.push_back(std::forward<E>(value));
+    }
+    const Item item{key, sequence, slot};
+    if (key <= last_) {
+      std::vector<Item>& bucket = buckets_[0];
+      bucket.push_back(item);
+      std::push_heap(bucket.begin(), bucket.end(), Later);
+    } else {
+      buckets_[BucketIndex(key, last_)].push_back(item);
+    }
+    ++size_;
+  }
+
+  // `TopKey()`, `TopSequence()`, `Top()`, and `Pop()` require the heap to not be `Empty()`.
+  uint64_t TopKey() {
+    EnsureBucketZeroIsNotEmpty();
+    return buckets_[0].front().key;
+  }
+
+  uint64_t TopSequence() {
+    EnsureBucketZeroIsNotEmpty();
+    return buckets_[0].front().sequence;
+  }
+
+  T& Top() {
+    EnsureBucketZeroIsNotEmpty();
+    return slab_[buckets_[0].front().slot];
+  }
+
+  void Pop() {
+    EnsureBucketZeroIsNotEmpty();
+    std::vector<Item>& bucket = buckets_[0];
+    free_slots_.push_back(bucket.front().slot);
+    std::pop_heap(bucket.begin(), bucket.end(), Later);
+    bucket.pop_back();
+    --size_;
+  }
+
+ private:
+  struct Item {
+    uint64_t key;
+    uint64_t sequence;
+    uint32_t slot;
+  };
+
+  // The comparator for the `std::*_heap` functions to keep the smallest `{key, sequence}` at the top of bucket zero.
+  static bool Later(const Item& lhs, const Item& rhs) {
+    return lhs.key > rhs.key || (lhs.key == rhs.key && lhs.sequence > rhs.sequence);
+  }
+
+  static size_t BucketIndex(uint64_t key, uint64_t last) {
+    if (key <= last) {
+      return 0u;
+    }
+    // The 1-based index of the most significant bit of `key ^ last`.
+    uint64_t x = key ^ last;
+    size_t result = 1u;
+    for (size_t shift = 32u; shift; shift >>= 1) {
+      if (x >> shift) {
+        x >>= shift;
+        result += shift;
+      }
+    }
+    return result;
+  }
+
+  // Moves the items of the lowest nonempty bucket into the lower ones, with its minimum becoming the new `last_`.
+  void EnsureBucketZeroIsNotEmpty() {
+    CURRENT_ASSERT(size_);
+    if (!buckets_[0].empty()) {
+      return;
+    }
+    size_t i = 1u;
+    while (buckets_[i].empty()) {
+      ++i;
+    }
+    std::vector<Item>& bucket = buckets_[i];
+    uint64_t new_last = bucket.front().key;
+    for (const Item& item : bucket) {
+      new_last = std::min(new_last, item.key);
+    }
+    last_ = new_last;
+    for (const Item& item : bucket) {
+      buckets_[BucketIndex(item.key, last_)].push_back(item);
+    }
+    bucket.clear();
+    std::make_heap(buckets_[0].begin(), buckets_[0].end(), Later);
+  }
+
+  std::array<std::vector<Item>, 65> buckets_;
+  uint64_t last_ = 0u;
+  size_t size_ = 0u;
+
+  std::vector<T> slab_;
+  std::vector<uint32_t> free_slots_;
+};
+
+}  // namespace mmq
+}  // namespace current
+
+#endif  // BLOCKS_MMQ_RADIX_HEAP_H
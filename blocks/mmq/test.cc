@@ -27,18 +27,23 @@ SOFTWARE.
 
 #include "mmq.h"
 #include "mmpq.h"
+#include "parallel_mmq.h"
+#include "radix_heap.h"
 
 #include <atomic>
 #include <chrono>
+#include <map>
 #include <thread>
 
 #include "../../bricks/strings/printf.h"
 #include "../../bricks/strings/join.h"
+#include "../../bricks/util/random.h"
 
 #include "../../3rdparty/gtest/gtest-main.h"
 
 using current::mmq::MMPQ;
 using current::mmq::MMQ;
+using current::mmq::ParallelMMQ;
 using current::ss::EntryResponse;
 
 TEST(InMemoryMQ, SmokeTest) {
@@ -219,6 +224,269 @@ TEST(InMemoryMQ, WaitOnOverflowTest) {
   EXPECT_EQ(100u, std::set<std::string>(c.messages_.begin(), c.messages_.end()).size());
 }
 
+TEST(InMemoryMQ, WaitPolicies) {
+  current::time::ResetToZero();
+
+  const auto run = [](auto&& mmq, SuspendableConsumer& c) {
+    // Overflow the queue of ten from several threads, so that both the consumer and the publishers have to wait.
+    std::vector<std::thread> producers;
+    for (size_t i = 0; i < 4; ++i) {
+      producers.emplace_back([&mmq, i]() {
+        for (size_t j = 0; j < 25; ++j) {
+          mmq.Publish(current::strings::Printf("%c%02d", static_cast<char>('a' + i), static_cast<int>(j)));
+        }
+      });
+    }
+    for (auto& p : producers) {
+      p.join();
+    }
+    while (c.processed_messages_ != 100u) {
+      std::this_thread::yield();
+    }
+    EXPECT_EQ(100u, std::set<std::string>(c.messages_.begin(), c.messages_.end()).size());
+  };
+
+  {
+    SuspendableConsumer c;
+    MMQ<std::string, SuspendableConsumer, 10, false, current::locks::SpinThenBlockWaitPolicy<100>> mmq(c);
+    run(mmq, c);
+  }
+
+  {
+    SuspendableConsumer c;
+    MMQ<std::string, SuspendableConsumer, 10, false, current::locks::BusyPollWaitPolicy> mmq(c);
+    run(mmq, c);
+  }
+}
+
+TEST(InMemoryMQ, BatchConsumerTest) {
+  current::time::ResetToZero();
+
+  struct BatchConsumer {
+    std::vector<std::string> messages_;
+    std::vector<std::string> batches_;
+    uint64_t expected_next_message_index_ = 1u;
+    std::atomic_size_t batches_entered_;
+    std::atomic_size_t batches_allowed_;
+    std::atomic_size_t processed_messages_;
+    BatchConsumer() : batches_entered_(0u), batches_allowed_(0u), processed_messages_(0u) {}
+    void operator()(current::mmq::MMQBatch<std::string>& batch) {
+      // Block until the test allows this batch through, so that the batch boundaries are deterministic.
+      const size_t batch_index = ++batches_entered_;
+      while (batches_allowed_ < batch_index) {
+        std::this_thread::yield();
+      }
+      batches_.push_back(current::strings::Printf("%d+%d,dropped=%d",
+                                                  static_cast<int>(batch.first.size()),
+                                                  static_cast<int>(batch.second.size()),
+                                                  static_cast<int>(batch.dropped)));
+      batch.ForEach([this](current::mmq::MMQEntry<std::string>& e) {
+        EXPECT_EQ(expected_next_message_index_, e.index_timestamp.index);
+        ++expected_next_message_index_;
+        messages_.push_back(std::move(e.message_body));
+      });
+      EXPECT_EQ(expected_next_message_index_ - 1u, batch.last.index);
+      processed_messages_ += batch.size();
+    }
+    void WaitForBatch(size_t n) {
+      while (batches_entered_ != n) {
+        std::this_thread::yield();
+      }
+    }
+  };
+
+  static_assert(current::mmq::IsBatchConsumer<BatchConsumer, std::string>::value, "");
+  static_assert(!current::mmq::IsBatchConsumer<SuspendableConsumer, std::string>::value, "");
+
+  {
+    // The queue of four, with the third batch wrapping around the end of the circular buffer.
+    BatchConsumer c;
+    MMQ<std::string, BatchConsumer, 4> mmq(c);
+    mmq.Publish("a");
+    c.WaitForBatch(1u);
+    mmq.Publish("b");
+    mmq.Publish("c");
+    c.batches_allowed_ = 1u;
+    c.WaitForBatch(2u);
+    mmq.Publish("d");
+    mmq.Publish("e");
+    c.batches_allowed_ = 2u;
+    c.WaitForBatch(3u);
+    c.batches_allowed_ = 3u;
+    while (c.processed_messages_ != 5u) {
+      std::this_thread::yield();
+    }
+    EXPECT_EQ("a b c d e", current::strings::Join(c.messages_, ' '));
+    EXPECT_EQ("1+0,dropped=0 2+0,dropped=0 1+1,dropped=0", current::strings::Join(c.batches_, ' '));
+  }
+
+  {
+    // The queue of four, dropping on overflow, with the consumer told how many messages were dropped.
+    BatchConsumer c;
+    MMQ<std::string, BatchConsumer, 4, true> mmq(c);
+    mmq.Publish("M00");
+    c.WaitForBatch(1u);
+    size_t messages_accepted = 1u;
+    for (size_t i = 1; i < 11; ++i) {
+      if (mmq.Publish(current::strings::Printf("M%02d", static_cast<int>(i))).index) {
+        ++messages_accepted;
+      }
+    }
+    EXPECT_EQ(4u, messages_accepted);
+    c.batches_allowed_ = 1u;
+    c.WaitForBatch(2u);
+    c.batches_allowed_ = 3u;
+    while (c.processed_messages_ != 4u) {
+      std::this_thread::yield();
+    }
+    mmq.Publish("Plus one");
+    while (c.processed_messages_ != 5u) {
+      std::this_thread::yield();
+    }
+    EXPECT_EQ("M00 M01 M02 M03 Plus one", current::strings::Join(c.messages_, ' '));
+    EXPECT_EQ("1+0,dropped=0 3+0,dropped=7 1+0,dropped=0", current::strings::Join(c.batches_, ' '));
+  }
+}
+
+namespace parallel_mmq_test {
+
+// The key of "key:value" is "key".
+struct KeyBeforeColon {
+  std::string operator()(const std::string& s) const { return s.substr(0u, s.find(':')); }
+};
+
+struct ConsumerImpl {
+  std::mutex mutex_;
+  std::map<std::string, std::vector<std::string>> values_per_key_;
+  std::map<std::string, std::set<std::thread::id>> threads_per_key_;
+  std::set<std::thread::id> threads_;
+  std::vector<uint64_t> indexes_;
+  std::atomic_size_t processed_messages_;
+  ConsumerImpl() : processed_messages_(0u) {}
+  EntryResponse operator()(const std::string& s, idxts_t current, idxts_t last) {
+    EXPECT_LE(current.index, last.index);
+    const size_t colon = s.find(':');
+    const std::string key = s.substr(0u, colon);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      values_per_key_[key].push_back(s.substr(colon + 1u));
+      threads_per_key_[key].insert(std::this_thread::get_id());
+      threads_.insert(std::this_thread::get_id());
+      indexes_.push_back(current.index);
+    }
+    ++processed_messages_;
+    return EntryResponse::More;
+  }
+};
+
+using Consumer = current::ss::EntrySubscriber<ConsumerImpl, std::string>;
+
+}  // namespace parallel_mmq_test
+
+TEST(InMemoryMQ, ParallelMMQPreservesPerKeyOrder) {
+  current::time::ResetToZero();
+
+  using parallel_mmq_test::Consumer;
+  using parallel_mmq_test::KeyBeforeColon;
+
+  Consumer c;
+  ParallelMMQ<std::string, Consumer, KeyBeforeColon, 5> mmq(c, 4u);
+  static_assert(current::ss::IsPublisher<decltype(mmq)>::value, "");
+  static_assert(current::ss::IsEntryPublisher<decltype(mmq), std::string>::value, "");
+  EXPECT_EQ(4u, mmq.WorkersCount());
+
+  const auto producer = [&](size_t first_key, size_t keys) {
+    for (size_t i = 0; i < 100; ++i) {
+      for (size_t k = first_key; k < first_key + keys; ++k) {
+        mmq.Publish(current::strings::Printf("k%02d:%03d", static_cast<int>(k), static_cast<int>(i)));
+      }
+    }
+  };
+
+  std::vector<std::thread> producers;
+  for (size_t i = 0; i < 4; ++i) {
+    producers.emplace_back(producer, i * 5u, 5u);
+  }
+  for (auto& p : producers) {
+    p.join();
+  }
+
+  while (c.processed_messages_ != 2000u) {
+    std::this_thread::yield();
+  }
+
+  std::lock_guard<std::mutex> lock(c.mutex_);
+  ASSERT_EQ(20u, c.values_per_key_.size());
+  for (const auto& key_values : c.values_per_key_) {
+    // All the messages of each key are processed by the same worker, in the order they were published.
+    ASSERT_EQ(100u, key_values.second.size());
+    for (size_t i = 0; i < 100u; ++i) {
+      EXPECT_EQ(current::strings::Printf("%03d", static_cast<int>(i)), key_values.second[i]) << key_values.first;
+    }
+    EXPECT_EQ(1u, c.threads_per_key_[key_values.first].size()) << key_values.first;
+  }
+  // Different keys are processed by more than one worker.
+  EXPECT_LT(1u, c.threads_.size());
+  // The indexes are global and unique.
+  std::sort(c.indexes_.begin(), c.indexes_.end());
+  EXPECT_EQ(1u, c.indexes_.front());
+  EXPECT_EQ(2000u, c.indexes_.back());
+  EXPECT_EQ(c.indexes_.end(), std::unique(c.indexes_.begin(), c.indexes_.end()));
+}
+
+TEST(InMemoryMQ, ParallelMMQDropOnOverflowIsPerWorker) {
+  current::time::ResetToZero();
+
+  using parallel_mmq_test::KeyBeforeColon;
+
+  struct BlockingConsumerImpl {
+    std::atomic_bool suspend_processing_;
+    std::atomic_size_t processed_messages_;
+    BlockingConsumerImpl() : suspend_processing_(true), processed_messages_(0u) {}
+    EntryResponse operator()(const std::string& s, idxts_t, idxts_t) {
+      while (s[0] == 'a' && suspend_processing_) {
+        std::this_thread::yield();
+      }
+      ++processed_messages_;
+      return EntryResponse::More;
+    }
+  };
+  using BlockingConsumer = current::ss::EntrySubscriber<BlockingConsumerImpl, std::string>;
+
+  BlockingConsumer c;
+  ParallelMMQ<std::string, BlockingConsumer, KeyBeforeColon, 3, true> mmq(c, 2u);
+
+  // Find the key which is handled by the other worker than key "a".
+  const size_t worker_a = std::hash<std::string>()("a") % 2u;
+  std::string other_key = "b";
+  while (std::hash<std::string>()(other_key) % 2u == worker_a) {
+    other_key += 'b';
+  }
+
+  // With the worker for "a" stuck, at most four messages with key "a" are accepted: one being processed plus three.
+  size_t accepted = 0u;
+  for (size_t i = 0; i < 10u; ++i) {
+    if (mmq.Publish("a:" + current::ToString(i)).index) {
+      ++accepted;
+    }
+  }
+  EXPECT_GE(accepted, 3u);
+  EXPECT_LE(accepted, 4u);
+
+  // The other worker is unaffected.
+  for (size_t i = 0; i < 10u; ++i) {
+    while (c.processed_messages_ != i) {
+      std::this_thread::yield();
+    }
+    EXPECT_NE(0u, mmq.Publish(other_key + ':' + current::ToString(i)).index);
+  }
+
+  c.suspend_processing_ = false;
+  while (c.processed_messages_ != 10u + accepted) {
+    std::this_thread::yield();
+  }
+}
+
 TEST(InMemoryMQ, TimeShouldNotGoBack) {
   current::time::ResetToZero();
 
@@ -413,3 +681,74 @@ TEST(InMemoryMQ, MMPQSupportsUpdateHead) {
   EXPECT_EQ("three @ 3, seven @ 7, ace @ 100, king @ 101, queen @ 102, jack @ 103, joker @ 1000",
             current::strings::Join(c.messages_by_timestamps_, ", "));
 }
+
+TEST(InMemoryMQ, RadixHeapMatchesOrderedSet) {
+  current::mmq::RadixHeap<std::string> heap;
+  std::set<std::pair<uint64_t, uint64_t>> golden;
+  uint64_t sequence = 0u;
+  uint64_t now = 1000u;
+  for (size_t iteration = 0u; iteration < 20000u; ++iteration) {
+    if (golden.empty() || current::random::RandomIntegral<int>(0, 2)) {
+      // Dense near future, sparse far future, and the occasional duplicate timestamp or one in the past.
+      const int kind = current::random::RandomIntegral<int>(0, 9);
+      uint64_t key;
+      if (kind < 6) {
+        key = now + current::random::RandomIntegral<uint64_t>(0u, 100u);
+      } else if (kind < 8) {
+        key = now + current::random::RandomIntegral<uint64_t>(0u, 1000000000u);
+      } else if (kind < 9) {
+        key = golden.empty() ? now : golden.begin()->first;
+      } else {
+        key = now - current::random::RandomIntegral<uint64_t>(0u, 10u);
+      }
+      ++sequence;
+      heap.Push(key, sequence, current::ToString(key) + '/' + current::ToString(sequence));
+      golden.emplace(key, sequence);
+    } else {
+      ASSERT_FALSE(heap.Empty());
+      const auto expected = *golden.begin();
+      golden.erase(golden.begin());
+      EXPECT_EQ(expected.second, heap.TopSequence());
+      EXPECT_EQ(expected.second, current::FromString<uint64_t>(heap.Top().substr(heap.Top().find('/') + 1u)));
+      now = std::max(now, heap.TopKey());
+      heap.Pop();
+    }
+    ASSERT_EQ(golden.size(), heap.Size());
+  }
+}
+
+TEST(InMemoryMQ, MMPQKeepsOrderOfEqualTimestamps) {
+  current::time::ResetToZero();
+
+  struct ConsumerImpl {
+    std::vector<std::string> messages_;
+    std::atomic_size_t processed_messages_;
+    ConsumerImpl() : processed_messages_(0u) {}
+    EntryResponse operator()(const std::string& s, idxts_t, idxts_t) {
+      messages_.push_back(s);
+      ++processed_messages_;
+      return EntryResponse::More;
+    }
+  };
+
+  using Consumer = current::ss::EntrySubscriber<ConsumerImpl, std::string>;
+
+  Consumer c;
+  MMPQ<std::string, Consumer> mmpq(c);
+  mmpq.Publish("b1", std::chrono::microseconds(20));
+  mmpq.Publish("a1", std::chrono::microseconds(10));
+  mmpq.Publish("b2", std::chrono::microseconds(20));
+  mmpq.Publish("a2", std::chrono::microseconds(10));
+  mmpq.Publish("far", std::chrono::microseconds(1000000000));
+  mmpq.Publish("b3", std::chrono::microseconds(20));
+  mmpq.UpdateHead(std::chrono::microseconds(20));
+  while (c.processed_messages_ != 5u) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ("a1 a2 b1 b2 b3", current::strings::Join(c.messages_, ' '));
+  mmpq.UpdateHead(std::chrono::microseconds(1000000000));
+  while (c.processed_messages_ != 6u) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ("far", c.messages_.back());
+}
@@ -64,6 +64,7 @@ struct SocketBindException : ServerSocketException {
 
 struct SocketListenException : ServerSocketException {};  // LCOV_EXCL_LINE -- not covered by unit tests.
 struct SocketAcceptException : ServerSocketException {};  // LCOV_EXCL_LINE -- not covered by unit tests.
+struct SocketReusePortException : ServerSocketException {};
 
 struct ConnectionResetByPeer : SocketException {};  // LCOV_EXCL_LINE
 
@@ -79,6 +80,7 @@ struct SocketFcntlException : SocketException {};
 struct SocketReadException : SocketException {};  // LCOV_EXCL_LINE -- TODO(dkorolev): We might want to test it.
 struct SocketWriteException : SocketException {};
 struct SocketCouldNotWriteEverythingException : SocketWriteException {};
+struct ReactorException : SocketException {};  // LCOV_EXCL_LINE -- not covered by unit tests.
 
 // We noticed some browsers, Firefox and Chrome included, may pre-open a TCP connection for performance reasons,
 // but never send any data. While it is a legitimate case, it results in an annoying warning dumped by Current.
@@ -99,6 +101,9 @@ struct HTTPRedirectNotAllowedException : HTTPException {};
 struct HTTPRedirectLoopException : HTTPException {
   using HTTPException::HTTPException;
 };
+struct HTTPTimeoutException : HTTPException {
+  using HTTPException::HTTPException;
+};
 struct HTTPPayloadTooLarge : HTTPException {};
 struct HTTPRequestBodyLengthNotProvided : HTTPException {};
 struct ChunkSizeNotAValidHEXValue : HTTPException {};
@@ -27,6 +27,7 @@ SOFTWARE.
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <type_traits>
@@ -121,19 +122,28 @@ struct HTTPResponder {
     }
   }
 
+  // The connection to send the response into, and whether it is kept open for the next request after it.
+  // Implicitly constructed from the bare `Connection&`, for the responses after which the connection is closed.
+  struct Destination final {
+    Connection& connection;
+    const ConnectionType connection_type;
+    Destination(Connection& connection, ConnectionType connection_type = ConnectionClose)
+        : connection(connection), connection_type(connection_type) {}
+  };
+
   // The generic implementation.
   template <typename T>
-  static void SendHTTPResponseImpl(Connection& connection,
+  static void SendHTTPResponseImpl(Destination destination,
                                    const T& begin,
                                    const T& end,
                                    HTTPResponseCodeValue code,
                                    const http::Headers& headers,
                                    const std::string& content_type) {
     std::ostringstream os;
-    PrepareHTTPResponseHeader(os, ConnectionClose, code, headers, content_type);
+    PrepareHTTPResponseHeader(os, destination.connection_type, code, headers, content_type);
     os << "Content-Length: " << (end - begin) << constants::kCRLF << constants::kCRLF;
-    connection.BlockingWrite(os.str(), true);
-    connection.BlockingWrite(begin, end, false);
+    destination.connection.BlockingWrite(os.str(), true);
+    destination.connection.BlockingWrite(begin, end, false);
   }
 
   // The actual implementations of sending the HTTP response.
@@ -143,7 +153,7 @@ struct HTTPResponder {
   // STL containers of chars and bytes, this does not yet cover std::string.
   template <typename T>
   static std::enable_if_t<sizeof(typename T::value_type) == 1> SendHTTPResponse(
-      Connection& connection,
+      Destination connection,
       const T& begin,
       const T& end,
       HTTPResponseCodeValue code,
@@ -154,7 +164,7 @@ struct HTTPResponder {
 
   template <typename T>
   static std::enable_if_t<sizeof(typename T::value_type) == 1> SendHTTPResponse(
-      Connection& connection,
+      Destination connection,
       const T& begin,
       const T& end,
       HTTPResponseCodeValue code,
@@ -165,7 +175,7 @@ struct HTTPResponder {
 
   template <typename T>
   static std::enable_if_t<sizeof(typename T::value_type) == 1> SendHTTPResponse(
-      Connection& connection,
+      Destination connection,
       const T& begin,
       const T& end,
       const std::string& content_type,
@@ -175,7 +185,7 @@ struct HTTPResponder {
 
   template <typename T>
   static std::enable_if_t<sizeof(typename T::value_type) == 1> SendHTTPResponse(
-      Connection& connection,
+      Destination connection,
       const T& begin,
       const T& end,
       const http::Headers& headers,
@@ -185,7 +195,7 @@ struct HTTPResponder {
 
   template <typename T>
   static std::enable_if_t<sizeof(typename T::value_type) == 1> SendHTTPResponse(
-      Connection& connection,
+      Destination connection,
       const T& begin,
       const T& end,
       HTTPResponseCodeValue code) {
@@ -194,7 +204,7 @@ struct HTTPResponder {
 
   template <typename T>
   static std::enable_if_t<sizeof(typename T::value_type) == 1> SendHTTPResponse(
-      Connection& connection,
+      Destination connection,
       const T& begin,
       const T& end) {
     SendHTTPResponseImpl(connection, begin, end, HTTPResponseCode.OK, http::Headers(), constants::kDefaultContentType);
@@ -203,7 +213,7 @@ struct HTTPResponder {
   // STL containers of chars and bytes.
   template <typename T>
   static std::enable_if_t<sizeof(typename T::value_type) == 1> SendHTTPResponse(
-      Connection& connection,
+      Destination connection,
       const T& obj,
       HTTPResponseCodeValue code,
       const std::string& content_type,
@@ -213,7 +223,7 @@ struct HTTPResponder {
 
   template <typename T>
   static std::enable_if_t<sizeof(typename T::value_type) == 1> SendHTTPResponse(
-      Connection& connection,
+      Destination connection,
       const T& obj,
       HTTPResponseCodeValue code,
       const http::Headers& headers,
@@ -223,7 +233,7 @@ struct HTTPResponder {
 
   template <typename T>
   static std::enable_if_t<sizeof(typename T::value_type) == 1> SendHTTPResponse(
-      Connection& connection,
+      Destination connection,
       const T& obj,
       const std::string& content_type,
       const http::Headers& headers) {
@@ -232,7 +242,7 @@ struct HTTPResponder {
 
   template <typename T>
   static std::enable_if_t<sizeof(typename T::value_type) == 1> SendHTTPResponse(
-      Connection& connection,
+      Destination connection,
       const T& obj,
       const http::Headers& headers,
       const std::string& content_type) {
@@ -241,20 +251,20 @@ struct HTTPResponder {
 
   template <typename T>
   static std::enable_if_t<sizeof(typename T::value_type) == 1> SendHTTPResponse(
-      Connection& connection,
+      Destination connection,
       const T& obj,
       HTTPResponseCodeValue code) {
     SendHTTPResponseImpl(connection, obj.begin(), obj.end(), code, http::Headers(), constants::kDefaultContentType);
   }
 
   template <typename T>
-  static std::enable_if_t<sizeof(typename T::value_type) == 1> SendHTTPResponse( Connection& connection,
+  static std::enable_if_t<sizeof(typename T::value_type) == 1> SendHTTPResponse( Destination connection,
       const T& obj) {
     SendHTTPResponseImpl(connection, obj.begin(), obj.end(), HTTPResponseCode.OK, http::Headers(), constants::kDefaultContentType);
   }
 
   // Special case to handle std::string.
-  static void SendHTTPResponse(Connection& connection,
+  static void SendHTTPResponse(Destination connection,
                                const std::string& string,
                                HTTPResponseCodeValue code,
                                const http::Headers& headers,
@@ -262,21 +272,21 @@ struct HTTPResponder {
     SendHTTPResponseImpl(connection, string.begin(), string.end(), code, headers, content_type);
   }
 
-  static void SendHTTPResponse(Connection& connection,
+  static void SendHTTPResponse(Destination connection,
                                const std::string& string,
                                HTTPResponseCodeValue code,
                                const http::Headers& headers) {
     SendHTTPResponseImpl(connection, string.begin(), string.end(), code, headers, constants::kDefaultContentType);
   }
 
-  static void SendHTTPResponse(Connection& connection,
+  static void SendHTTPResponse(Destination connection,
                                const std::string& string,
                                HTTPResponseCodeValue code,
                                const std::string& content_type) {
     SendHTTPResponseImpl(connection, string.begin(), string.end(), code, http::Headers(), content_type);
   }
 
-  static void SendHTTPResponse(Connection& connection, const std::string& string, HTTPResponseCodeValue code) {
+  static void SendHTTPResponse(Destination connection, const std::string& string, HTTPResponseCodeValue code) {
     SendHTTPResponseImpl(connection,
                          string.begin(),
                          string.end(),
@@ -285,7 +295,7 @@ struct HTTPResponder {
                          constants::kDefaultContentType);
   }
 
-  static void SendHTTPResponse(Connection& connection, const std::string& string) {
+  static void SendHTTPResponse(Destination connection, const std::string& string) {
     SendHTTPResponseImpl(connection,
                          string.begin(),
                          string.end(),
@@ -297,7 +307,7 @@ struct HTTPResponder {
   // Support `CURRENT_STRUCT`-s and `CURRENT_VARIANT`-s.
   template <class T>
   static std::enable_if_t<IS_CURRENT_STRUCT_OR_VARIANT(current::decay_t<T>)> SendHTTPResponse(
-      Connection& connection,
+      Destination connection,
       T&& object,
       HTTPResponseCodeValue code,
       const http::Headers& headers,
@@ -309,7 +319,7 @@ struct HTTPResponder {
 
   template <class T>
   static std::enable_if_t<IS_CURRENT_STRUCT_OR_VARIANT(current::decay_t<T>)> SendHTTPResponse(
-      Connection& connection,
+      Destination connection,
       T&& object,
       HTTPResponseCodeValue code,
       const http::Headers& headers) {
@@ -320,7 +330,7 @@ struct HTTPResponder {
 
   template <class T>
   static std::enable_if_t<IS_CURRENT_STRUCT_OR_VARIANT(current::decay_t<T>)> SendHTTPResponse(
-      Connection& connection,
+      Destination connection,
       T&& object,
       HTTPResponseCodeValue code,
       const std::string& content_type) {
@@ -331,7 +341,7 @@ struct HTTPResponder {
 
   template <class T>
   static std::enable_if_t<IS_CURRENT_STRUCT_OR_VARIANT(current::decay_t<T>)> SendHTTPResponse(
-      Connection& connection,
+      Destination connection,
       T&& object,
       HTTPResponseCodeValue code) {
     // TODO(dkorolev): We should probably make this not only correct but also efficient.
@@ -341,7 +351,7 @@ struct HTTPResponder {
 
   template <class T>
   static std::enable_if_t<IS_CURRENT_STRUCT_OR_VARIANT(current::decay_t<T>)> SendHTTPResponse(
-      Connection& connection,
+      Destination connection,
       T&& object) {
     // TODO(dkorolev): We should probably make this not only correct but also efficient.
     const std::string s = JSON(std::forward<T>(object)) + '\n';
@@ -478,6 +488,8 @@ class GenericHTTPRequestData : public HELPER {
               raw_path_ = pieces[1];
               url_ = current::url::URL(raw_path_);
             }
+            // HTTP/1.1 connections are persistent unless told otherwise, and HTTP/1.0 ones are the other way around.
+            keep_alive_ = (pieces.size() >= 3 && pieces[2] == "HTTP/1.1");
             first_line_parsed = true;
           }
         } else if (receiving_body_in_chunks) {
@@ -499,6 +511,8 @@ class GenericHTTPRequestData : public HELPER {
             if (chunk_length == 0) {
               // Done with the body.
               HELPER::OnChunkedBodyDone(body_buffer_begin_, body_buffer_end_);
+              // The CRLF after the last chunk, if already read, is skipped as a blank line by the next request.
+              c.Unread(&buffer_[next_line_offset], &buffer_[offset]);
               return;
             } else {
               // A chunk of length `chunk_length` bytes starts right at next_line_offset.
@@ -577,6 +591,12 @@ class GenericHTTPRequestData : public HELPER {
               if (HeaderNameEquals(value, constants::kTransferEncodingChunkedValue)) {
                 chunked_transfer_encoding = true;
               }
+            } else if (HeaderNameEquals(key, constants::kConnectionHeaderKey)) {
+              if (HeaderNameEquals(value, constants::kConnectionKeepAliveValue)) {
+                keep_alive_ = true;
+              } else if (HeaderNameEquals(value, constants::kConnectionCloseValue)) {
+                keep_alive_ = false;
+              }
             }
           }
         } else {
@@ -599,6 +619,9 @@ class GenericHTTPRequestData : public HELPER {
                 if (bytes_to_read != c.BlockingRead(&buffer_[offset], bytes_to_read, Connection::FillFullBuffer)) {
                   CURRENT_THROW(ConnectionResetByPeer());  // LCOV_EXCL_LINE
                 }
+              } else {
+                // Whatever was read past the body is the beginning of the next, pipelined, request.
+                c.Unread(&buffer_[length_cap], &buffer_[offset]);
               }
               body_buffer_begin_ = &buffer_[body_offset];
               body_buffer_end_ = body_buffer_begin_ + body_length;
@@ -612,6 +635,7 @@ class GenericHTTPRequestData : public HELPER {
                                                 net::constants::kDefaultHTMLContentType);
                 CURRENT_THROW(HTTPRequestBodyLengthNotProvided());
               }
+              c.Unread(&buffer_[body_offset], &buffer_[offset]);
               return;
             }
           } else {
@@ -640,6 +664,9 @@ class GenericHTTPRequestData : public HELPER {
   inline const current::url::URL& URL() const { return url_; }
   inline const std::string& RawPath() const { return raw_path_; }
 
+  // Whether the client is fine with the connection staying open after the response, for the next request.
+  inline bool KeepAlive() const { return keep_alive_; }
+
   // Note that `Body*()` methods assume that the body was fully read into memory.
   // If other means of reading the body, for example, event-based chunk parsing, is used,
   // then `Body()` will return empty string and all other `Body*()` methods will return nullptr.
@@ -683,6 +710,7 @@ class GenericHTTPRequestData : public HELPER {
   std::string method_;
   current::url::URL url_;
   std::string raw_path_;
+  bool keep_alive_ = false;
 
   // HTTP parsing fields that have to be caried out of the parsing routine.
   std::vector<char> buffer_;                 // The buffer into which data has been read, except for chunked case.
@@ -706,6 +734,78 @@ using HTTPRequestData = GenericHTTPRequestData<HTTPDefaultHelper>;
 
 enum class ChunkFlush : bool { NoFlush = false, Flush = true };
 
+// The hand-off of a persistent connection back to the thread that serves it, once the request is answered.
+// Shared between that thread and the request, as the latter may be answered, and destroyed, from another thread.
+// Only the connections answered while the serving thread still waits for them are kept open, the rest are closed.
+struct HTTPKeepAlive final {
+  std::mutex mutex;
+  bool waiting = true;
+  std::unique_ptr<Connection> connection;
+
+  // Called by the serving thread once the handler has returned. Returns the connection to read the next request from,
+  // or `nullptr` if the request has not been answered, or if it is not to be followed by more requests.
+  std::unique_ptr<Connection> StopWaiting() {
+    std::lock_guard<std::mutex> lock(mutex);
+    waiting = false;
+    return std::move(connection);
+  }
+};
+
+#ifdef CURRENT_POSIX
+// The chunked response streamed via the `Reactor`, for the clients that are idle most of the time, such as
+// the subscribers waiting for rare updates. Sending never blocks, and no thread is kept busy per client.
+// The copies share the response, which is completed with the final "zero" chunk once the last one is gone.
+class ReactorChunkedResponseSender final {
+ public:
+  explicit ReactorChunkedResponseSender(std::shared_ptr<ReactorConnection> connection)
+      : impl_(std::make_shared<Impl>(std::move(connection))) {}
+
+  // Throws `SocketWriteException` once the client has gone away, as the blocking `ChunkedResponseSender` does.
+  // The chunks sent with `ChunkFlush::NoFlush` are held back, and written along with the next flushed one.
+  ReactorChunkedResponseSender& Send(const std::string& data, ChunkFlush flush = ChunkFlush::Flush) {
+    if (!data.empty()) {
+      impl_->pending += strings::Printf("%lX", data.size()) + constants::kCRLF + data + constants::kCRLF;
+    }
+    if (!impl_->pending.empty() &&
+        (flush == ChunkFlush::Flush || impl_->pending.length() >= CURRENT_BRICKS_HTTP_DEFAULT_CHUNK_CACHE_SIZE)) {
+      std::string output;
+      output.swap(impl_->pending);
+      if (!impl_->connection->Write(std::move(output))) {
+        CURRENT_THROW(SocketWriteException());
+      }
+    }
+    return *this;
+  }
+
+  // Support `CURRENT_STRUCT`-s.
+  template <class T>
+  std::enable_if_t<IS_CURRENT_STRUCT(current::decay_t<T>), ReactorChunkedResponseSender&> Send(
+      T&& object, ChunkFlush flush = ChunkFlush::Flush) {
+    return Send(JSON(std::forward<T>(object)) + '\n', flush);
+  }
+
+  template <typename T>
+  ReactorChunkedResponseSender& operator()(T&& data, ChunkFlush flush = ChunkFlush::Flush) {
+    return Send(std::forward<T>(data), flush);
+  }
+
+  bool Closed() const { return impl_->connection->Closed(); }
+  size_t BufferedBytes() const { return impl_->connection->BufferedBytes(); }
+
+ private:
+  struct Impl final {
+    explicit Impl(std::shared_ptr<ReactorConnection> connection) : connection(std::move(connection)) {}
+    ~Impl() {
+      connection->Write(pending + "0" + constants::kCRLF + constants::kCRLF);
+      connection->Close();
+    }
+    std::shared_ptr<ReactorConnection> connection;
+    std::string pending;
+  };
+  std::shared_ptr<Impl> impl_;
+};
+#endif  // CURRENT_POSIX
+
 template <class HTTP_REQUEST_DATA>
 class GenericHTTPServerConnection final : public HTTPResponder {
  public:
@@ -718,6 +818,12 @@ class GenericHTTPServerConnection final : public HTTPResponder {
       const double buffer_growth_k = 1.95)
       : connection_(std::move(c)), message_(connection_, params, initial_buffer_size, buffer_growth_k) {}
   ~GenericHTTPServerConnection() {
+    if (kept_alive_) {
+      std::lock_guard<std::mutex> lock(keep_alive_->mutex);
+      if (keep_alive_->waiting) {
+        keep_alive_->connection = std::make_unique<Connection>(std::move(connection_));
+      }
+    }
     if (!responded_) {
       // If a user code throws an exception in a different thread, it will not be caught.
       // But, at least, capitalized "INTERNAL SERVER ERROR" will be returned.
@@ -745,13 +851,30 @@ class GenericHTTPServerConnection final : public HTTPResponder {
     }
   }
 
+  // Lets the connection serve more requests after this one, if the client is fine with it.
+  // Called by the serving thread before the request is passed on to the handler.
+  void KeepAlive(std::shared_ptr<HTTPKeepAlive> keep_alive) {
+    if (message_.KeepAlive()) {
+      keep_alive_ = std::move(keep_alive);
+    }
+  }
+
   template <typename... ARGS>
   void SendHTTPResponse(ARGS&&... args) {
     if (responded_) {
       CURRENT_THROW(AttemptedToSendHTTPResponseMoreThanOnce());
     } else {
-      HTTPResponder::SendHTTPResponse(connection_, std::forward<ARGS>(args)...);
+      const ConnectionType connection_type = [this]() {
+        if (keep_alive_) {
+          std::lock_guard<std::mutex> lock(keep_alive_->mutex);
+          return keep_alive_->waiting ? ConnectionKeepAlive : ConnectionClose;
+        } else {
+          return ConnectionClose;
+        }
+      }();
+      HTTPResponder::SendHTTPResponse(Destination(connection_, connection_type), std::forward<ARGS>(args)...);
       responded_ = true;
+      kept_alive_ = (connection_type == ConnectionKeepAlive);
     }
   }
 
@@ -894,6 +1017,31 @@ class GenericHTTPServerConnection final : public HTTPResponder {
     }
   }
 
+#ifdef CURRENT_POSIX
+  // Sends the headers of the chunked response, and hands the connection over to the `reactor`, to stream the chunks
+  // without blocking. The connection is closed once the response is complete.
+  ReactorChunkedResponseSender SendChunkedHTTPResponseViaReactor(
+      HTTPResponseCodeValue code = HTTPResponseCode.OK,
+      const http::Headers& headers = http::Headers(),
+      const std::string& content_type = constants::kDefaultJSONContentType,
+      Reactor& reactor = DefaultReactor()) {
+    if (responded_) {
+      CURRENT_THROW(AttemptedToSendHTTPResponseMoreThanOnce());
+    } else {
+      responded_ = true;
+      std::ostringstream os;
+      PrepareHTTPResponseHeader(os, ConnectionClose, code, headers, content_type);
+      os << "Transfer-Encoding: chunked" << constants::kCRLF << constants::kCRLF;
+      auto connection = reactor.Adopt(std::make_unique<Connection>(std::move(connection_)));
+      if (!connection->Write(os.str())) {
+        connection->Close();                    // LCOV_EXCL_LINE
+        CURRENT_THROW(SocketWriteException());  // LCOV_EXCL_LINE
+      }
+      return ReactorChunkedResponseSender(std::move(connection));
+    }
+  }
+#endif  // CURRENT_POSIX
+
   // To allow for a clean shutdown, without throwing an exception
   // that a response, that does not have to be sent, was really not sent.
   inline void DoNotSendAnyResponse() {
@@ -912,6 +1060,11 @@ class GenericHTTPServerConnection final : public HTTPResponder {
 
  private:
   bool responded_ = false;
+  // The hand-off of this connection to the next request, if the serving thread allows for one.
+  std::shared_ptr<HTTPKeepAlive> keep_alive_;
+  // Whether the response went out with `Connection: keep-alive`. Never the case for the chunked responses,
+  // as they may stream for as long as they like, and their connections are closed once they are done.
+  bool kept_alive_ = false;
   Connection connection_;
   GenericHTTPRequestData<HTTP_REQUEST_DATA> message_;
 
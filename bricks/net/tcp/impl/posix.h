@@ -46,6 +46,7 @@ rm -f core ; while true ; do ./.current/test --gtest_throw_on_failure --gtest_ca
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <netinet/tcp.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
@@ -66,6 +67,7 @@ typedef int SOCKET;
 
 #endif  // CURRENT_WINDOWS
 
+#include <chrono>
 #include <iostream>
 #include <cstring>
 #include <string>
@@ -84,6 +86,11 @@ namespace net {
 enum class NagleAlgorithm : bool { Disable, Keep };
 const NagleAlgorithm kDefaultNagleAlgorithmPolicy = NagleAlgorithm::Keep;
 
+// `ReusePort::Enable` lets several listening sockets bind to the same port, with the kernel spreading
+// the incoming connections across them. Only supported on Linux, where it maps onto `SO_REUSEPORT`.
+enum class ReusePort : bool { Disable, Enable };
+const ReusePort kDefaultReusePortPolicy = ReusePort::Disable;
+
 enum class MaxServerQueuedConnectionsValue : int {};
 const MaxServerQueuedConnectionsValue kMaxServerQueuedConnections = MaxServerQueuedConnectionsValue(1024);
 
@@ -156,8 +163,13 @@ class SocketHandle : private SocketSystemInitializer {
   explicit SocketHandle(BindAndListen,
                         BarePort bare_port,
                         NagleAlgorithm nagle_algorithm_policy = kDefaultNagleAlgorithmPolicy,
-                        MaxServerQueuedConnectionsValue max_connections = kMaxServerQueuedConnections)
+                        MaxServerQueuedConnectionsValue max_connections = kMaxServerQueuedConnections,
+                        ReusePort reuse_port_policy = kDefaultReusePortPolicy)
       : SocketHandle(InternalInit(), nagle_algorithm_policy) {
+    if (reuse_port_policy == ReusePort::Enable) {
+      EnableReusePort();
+    }
+
     sockaddr_in addr_server;
     memset(&addr_server, 0, sizeof(addr_server));
     addr_server.sin_family = AF_INET;
@@ -211,6 +223,19 @@ class SocketHandle : private SocketSystemInitializer {
 
   explicit SocketHandle(SocketHandle&& rhs) : socket_(static_cast<SOCKET>(-1)) { std::swap(socket_, rhs.socket_); }
 
+  // Allows more sockets, which also have `SO_REUSEPORT` set, to bind to the port of this one.
+  // On Linux it is fine to call this on a socket that is already listening.
+  void EnableReusePort() {
+#ifdef CURRENT_POSIX
+    int just_one = 1;
+    if (::setsockopt(socket_, SOL_SOCKET, SO_REUSEPORT, &just_one, sizeof(just_one))) {
+      CURRENT_THROW(SocketReusePortException());  // LCOV_EXCL_LINE -- Not covered by the unit tests.
+    }
+#else
+    CURRENT_THROW(SocketReusePortException());
+#endif  // CURRENT_POSIX
+  }
+
  private:
   friend class Socket;
   SOCKET socket_;
@@ -404,6 +429,16 @@ class Connection : public SocketHandle {
       T* output_buffer, size_t max_length, BlockingReadPolicy policy = BlockingReadPolicy::ReturnASAP) {
     if (max_length == 0) {
       return 0;  // LCOV_EXCL_LINE
+    } else if (!unread_.empty()) {
+      // Return the bytes put back by `Unread()` first.
+      const size_t length = std::min(max_length, unread_.length());
+      std::memcpy(output_buffer, unread_.data(), length);
+      unread_.erase(0, length);
+      if (length == max_length || policy == BlockingReadPolicy::ReturnASAP) {
+        return length;
+      } else {
+        return length + BlockingRead(output_buffer + length, max_length - length, policy);
+      }
     } else {
       uint8_t* buffer = reinterpret_cast<uint8_t*>(output_buffer);
       uint8_t* ptr = buffer;
@@ -507,6 +542,31 @@ class Connection : public SocketHandle {
     }
   }
 
+  // Puts back the bytes read past the end of a message, for the next `BlockingRead()` to return them first.
+  // This is how the HTTP requests pipelined into the same packet as the previous one are not lost.
+  void Unread(const char* begin, const char* end) { unread_.insert(0, begin, end - begin); }
+
+  // Waits for the peer to send more data, or to close the connection, for up to `timeout`.
+  // Returns `false` if the time has run out with nothing to read.
+  bool WaitForIncomingData(std::chrono::milliseconds timeout) {
+    if (!unread_.empty()) {
+      return true;
+    }
+#ifndef CURRENT_WINDOWS
+    pollfd fd;
+    fd.fd = socket;
+    fd.events = POLLIN;
+    fd.revents = 0;
+    return ::poll(&fd, 1, static_cast<int>(timeout.count())) > 0;
+#else
+    WSAPOLLFD fd;
+    fd.fd = socket;
+    fd.events = POLLRDNORM;
+    fd.revents = 0;
+    return ::WSAPoll(&fd, 1, static_cast<int>(timeout.count())) > 0;
+#endif  // CURRENT_WINDOWS
+  }
+
   Connection& BlockingWrite(const void* buffer, size_t write_length, bool more) {
 #if defined(CURRENT_APPLE) || defined(CURRENT_WINDOWS)
     static_cast<void>(more);  // Supress the 'unused parameter' warning.
@@ -556,6 +616,7 @@ class Connection : public SocketHandle {
  private:
   const IPAndPort local_ip_and_port_;
   const IPAndPort remote_ip_and_port_;
+  std::string unread_;
 
   Connection() = delete;
   Connection(const Connection&) = delete;
@@ -567,8 +628,10 @@ class Socket final : public SocketHandle {
  public:
   explicit Socket(BarePort bare_port,
                   NagleAlgorithm nagle_algorithm_policy = kDefaultNagleAlgorithmPolicy,
-                  MaxServerQueuedConnectionsValue max_connections = kMaxServerQueuedConnections)
-      : SocketHandle(SocketHandle::BindAndListen(), bare_port, nagle_algorithm_policy, max_connections) {}
+                  MaxServerQueuedConnectionsValue max_connections = kMaxServerQueuedConnections,
+                  ReusePort reuse_port_policy = kDefaultReusePortPolicy)
+      : SocketHandle(
+            SocketHandle::BindAndListen(), bare_port, nagle_algorithm_policy, max_connections, reuse_port_policy) {}
 
   explicit Socket(ReservedLocalPort&& reserved_port) : SocketHandle(std::move(reserved_port)) {}
 
@@ -0,0 +1,630 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2026 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// The `Reactor` watches many mostly idle connections from a single thread, with edge-triggered `epoll`,
+// so that holding them costs memory, not threads. Linux only.
+//
+// It takes the connections over in one of two ways.
+// * `Park()`: The idle connection is watched until the peer sends something, and is then handed back to the caller,
+//             to read from it in the regular, blocking, way. Used for the kept alive HTTP connections between requests.
+// * `Adopt()`: The connection is kept by the reactor, and written to without blocking, from any thread. The data
+//              the socket does not take right away is buffered per connection, and sent once the peer reads more.
+//              Used to stream the chunked HTTP responses to the clients that receive updates rarely.
+// Both kinds of connections are closed once their timers fire. Also, for the non-blocking protocols built atop
+// the reactor, such as the asynchronous HTTP client, `Watch()` reports the raw `epoll` events of a socket,
+// which stays owned by the caller. The callbacks are run on the thread of the reactor, so they should be quick,
+// and must not throw.
+
+#ifndef BRICKS_NET_TCP_IMPL_REACTOR_H
+#define BRICKS_NET_TCP_IMPL_REACTOR_H
+
+#include "../../../port.h"
+
+#ifdef CURRENT_POSIX
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "posix.h"
+
+#include "../../exceptions.h"
+
+#include "../../../util/singleton.h"
+
+namespace current {
+namespace net {
+
+class Reactor;
+
+inline void SetBlocking(SOCKET fd, bool blocking) {
+  const int flags = ::fcntl(fd, F_GETFL, 0);
+  if (flags < 0 || ::fcntl(fd, F_SETFL, blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK))) {
+    CURRENT_THROW(SocketFcntlException());  // LCOV_EXCL_LINE
+  }
+}
+
+// The connection adopted by the `Reactor`. Thread-safe.
+class ReactorConnection final {
+ public:
+  // Sends as much of `data` right away as the socket takes, and queues the rest, for the reactor to send it later.
+  // Returns `false`, dropping the data, if the connection is closed, is being closed, or the peer has gone away.
+  bool Write(std::string data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closing_ || closed_ || broken_) {
+      return false;
+    }
+    last_write_ = std::chrono::steady_clock::now();
+    if (output_offset_ == output_.length()) {
+      output_ = std::move(data);
+      output_offset_ = 0u;
+    } else {
+      output_.append(data);
+    }
+    return Flush();
+  }
+
+  // Closes the connection once the data queued so far has been sent.
+  void Close();
+
+  // Whether the connection has been closed, by either side.
+  bool Closed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return closed_ || broken_;
+  }
+
+  // The number of bytes written but not yet taken by the socket. Lets the writers hold off for the slow readers.
+  size_t BufferedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return output_.length() - output_offset_;
+  }
+
+ private:
+  friend class Reactor;
+
+  ReactorConnection(Reactor* reactor,
+                    uint64_t id,
+                    std::unique_ptr<Connection> connection,
+                    std::function<void()> on_closed,
+                    std::chrono::milliseconds idle_timeout)
+      : reactor_(reactor),
+        id_(id),
+        fd_(connection->socket),
+        idle_timeout_(idle_timeout),
+        connection_(std::move(connection)),
+        on_closed_(std::move(on_closed)),
+        last_write_(std::chrono::steady_clock::now()) {}
+
+  // Sends the queued data until the socket would block. Returns `false` if the peer has gone away. Under `mutex_`.
+  bool Flush() {
+    while (output_offset_ < output_.length()) {
+      const ssize_t sent = ::send(
+          fd_, output_.data() + output_offset_, output_.length() - output_offset_, MSG_NOSIGNAL | MSG_DONTWAIT);
+      if (sent > 0) {
+        output_offset_ += static_cast<size_t>(sent);
+      } else if (sent < 0 && errno == EINTR) {
+        continue;
+      } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        break;
+      } else {
+        broken_ = true;
+        break;
+      }
+    }
+    if (broken_ || output_offset_ == output_.length()) {
+      // Release the buffer of the drained connection, as most of them are idle most of the time.
+      std::string().swap(output_);
+      output_offset_ = 0u;
+    } else if (output_offset_ * 2u > output_.length()) {
+      output_.erase(0u, output_offset_);
+      output_offset_ = 0u;
+    }
+    return !broken_;
+  }
+
+  // Reads and drops whatever the peer sends. Returns `false` once the peer has closed the connection.
+  bool DiscardInput() {
+    char buffer[4096];
+    while (true) {
+      const ssize_t received = ::recv(fd_, buffer, sizeof(buffer), MSG_DONTWAIT);
+      if (received > 0 || (received < 0 && errno == EINTR)) {
+        continue;
+      }
+      return received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+  }
+
+  Reactor* reactor_;
+  const uint64_t id_;
+  const SOCKET fd_;
+  const std::chrono::milliseconds idle_timeout_;
+  // The timer of this connection in the reactor, guarded by the mutex of the reactor.
+  std::chrono::steady_clock::time_point deadline_;
+
+  mutable std::mutex mutex_;
+  std::unique_ptr<Connection> connection_;
+  std::function<void()> on_closed_;
+  std::string output_;
+  size_t output_offset_ = 0u;
+  std::chrono::steady_clock::time_point last_write_;
+  bool closing_ = false;
+  bool closed_ = false;
+  bool broken_ = false;
+
+  ReactorConnection(const ReactorConnection&) = delete;
+  void operator=(const ReactorConnection&) = delete;
+};
+
+class Reactor final {
+ public:
+  Reactor() : epoll_fd_(::epoll_create1(EPOLL_CLOEXEC)), wakeup_fd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+    if (epoll_fd_ < 0 || wakeup_fd_ < 0) {
+      CURRENT_THROW(ReactorException());  // LCOV_EXCL_LINE
+    }
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u64 = kWakeupID;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &event)) {
+      CURRENT_THROW(ReactorException());  // LCOV_EXCL_LINE
+    }
+    thread_ = std::thread([this]() { Thread(); });
+  }
+
+  // Closes all the connections still parked or adopted.
+  ~Reactor() {
+    terminating_ = true;
+    Wake();
+    thread_.join();
+    for (auto& adopted : adopted_) {
+      ReactorConnection& connection = *adopted.second;
+      std::lock_guard<std::mutex> lock(connection.mutex_);
+      connection.reactor_ = nullptr;
+      connection.closed_ = true;
+      connection.connection_ = nullptr;
+    }
+    parked_.clear();
+    adopted_.clear();
+    watched_.clear();
+    ::close(epoll_fd_);
+    ::close(wakeup_fd_);
+  }
+
+  // Watches the idle connection, and hands it to `on_readable` once the peer sends something or closes it.
+  // The connection is closed if neither happens within `timeout`.
+  void Park(std::unique_ptr<Connection> connection,
+            std::chrono::milliseconds timeout,
+            std::function<void(std::unique_ptr<Connection>)> on_readable) {
+    const SOCKET fd = connection->socket;
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    bool wake = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      const uint64_t id = ++last_id_;
+      parked_.emplace(id, Parked{std::move(connection), std::move(on_readable), deadline});
+      deadlines_.emplace(deadline, id);
+      // Under the lock, so that the connection can not time out, and get closed, before it is watched.
+      AddToEpoll(fd, id, EPOLLIN | EPOLLRDHUP | EPOLLET, [this, id, deadline]() {
+        deadlines_.erase(std::make_pair(deadline, id));
+        parked_.erase(id);
+      });
+      wake = (deadline < sleeping_until_);
+    }
+    if (wake) {
+      Wake();
+    }
+  }
+
+  // Takes the connection over, for it to be written to without blocking. `on_closed` is called once the connection
+  // is closed, be it by `Close()`, by the peer, or, if `idle_timeout` is set, once nothing has been written for it.
+  std::shared_ptr<ReactorConnection> Adopt(std::unique_ptr<Connection> connection,
+                                           std::function<void()> on_closed = nullptr,
+                                           std::chrono::milliseconds idle_timeout = std::chrono::milliseconds(0)) {
+    bool wake = false;
+    std::shared_ptr<ReactorConnection> result;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      const uint64_t id = ++last_id_;
+      result.reset(new ReactorConnection(this, id, std::move(connection), std::move(on_closed), idle_timeout));
+      adopted_.emplace(id, result);
+      AddToEpoll(result->fd_, id, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, [this, id]() { adopted_.erase(id); });
+      if (idle_timeout.count()) {
+        result->deadline_ = std::chrono::steady_clock::now() + idle_timeout;
+        deadlines_.emplace(result->deadline_, id);
+        wake = (result->deadline_ < sleeping_until_);
+      }
+    }
+    if (wake) {
+      Wake();
+    }
+    return result;
+  }
+
+  // Calls `on_event` with the edge-triggered `epoll` events of the socket, until `Unwatch()` is called with the id
+  // passed to it, which should be done before closing the socket. If that does not happen within `timeout`,
+  // the socket is unwatched by the reactor, and `on_timeout` is called instead.
+  uint64_t Watch(SOCKET fd,
+                 uint32_t events,
+                 std::chrono::milliseconds timeout,
+                 std::function<void(uint64_t id, uint32_t events)> on_event,
+                 std::function<void()> on_timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    bool wake = false;
+    uint64_t id;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      id = ++last_id_;
+      watched_.emplace(id,
+                       std::make_shared<Watched>(Watched{fd, std::move(on_event), std::move(on_timeout), deadline}));
+      deadlines_.emplace(deadline, id);
+      AddToEpoll(fd, id, events | EPOLLET, [this, id, deadline]() {
+        deadlines_.erase(std::make_pair(deadline, id));
+        watched_.erase(id);
+      });
+      wake = (deadline < sleeping_until_);
+    }
+    if (wake) {
+      Wake();
+    }
+    return id;
+  }
+
+  // Calls `on_timeout` after `timeout`, unless `Unwatch()` is called with the returned id before that.
+  uint64_t SetTimer(std::chrono::milliseconds timeout, std::function<void()> on_timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    bool wake = false;
+    uint64_t id;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      id = ++last_id_;
+      watched_.emplace(
+          id, std::make_shared<Watched>(Watched{static_cast<SOCKET>(-1), nullptr, std::move(on_timeout), deadline}));
+      deadlines_.emplace(deadline, id);
+      wake = (deadline < sleeping_until_);
+    }
+    if (wake) {
+      Wake();
+    }
+    return id;
+  }
+
+  void Unwatch(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto cit = watched_.find(id);
+    if (cit != watched_.end()) {
+      RemoveFromEpoll(cit->second->fd);
+      deadlines_.erase(std::make_pair(cit->second->deadline, id));
+      watched_.erase(cit);
+    }
+  }
+
+  size_t ParkedConnections() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return parked_.size();
+  }
+
+  size_t AdoptedConnections() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return adopted_.size();
+  }
+
+ private:
+  friend class ReactorConnection;
+
+  struct Parked final {
+    std::unique_ptr<Connection> connection;
+    std::function<void(std::unique_ptr<Connection>)> on_readable;
+    std::chrono::steady_clock::time_point deadline;
+  };
+
+  struct Watched final {
+    SOCKET fd;
+    std::function<void(uint64_t, uint32_t)> on_event;
+    std::function<void()> on_timeout;
+    std::chrono::steady_clock::time_point deadline;
+  };
+
+  using time_point_t = std::chrono::steady_clock::time_point;
+
+  constexpr static uint64_t kWakeupID = 0u;
+  constexpr static int kMaxEventsPerWait = 1024;
+
+  // Under `mutex_`. Rolls the registration back if the socket can not be watched.
+  template <typename F>
+  void AddToEpoll(SOCKET fd, uint64_t id, uint32_t events, F&& rollback) {
+    epoll_event event;
+    event.events = events;
+    event.data.u64 = id;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event)) {
+      rollback();                         // LCOV_EXCL_LINE
+      CURRENT_THROW(ReactorException());  // LCOV_EXCL_LINE
+    }
+  }
+
+  void RemoveFromEpoll(SOCKET fd) {
+    if (fd == static_cast<SOCKET>(-1)) {
+      return;
+    }
+    epoll_event unused;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, &unused);
+  }
+
+  void Wake() {
+    const uint64_t one = 1u;
+    static_cast<void>(::write(wakeup_fd_, &one, sizeof(one)));
+  }
+
+  void ScheduleClose(uint64_t id) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closing_.push_back(id);
+    }
+    Wake();
+  }
+
+  void Thread() {
+    std::vector<epoll_event> events(kMaxEventsPerWait);
+    while (!terminating_) {
+      int timeout_ms = -1;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (deadlines_.empty()) {
+          sleeping_until_ = time_point_t::max();
+        } else {
+          sleeping_until_ = deadlines_.begin()->first;
+          const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+              sleeping_until_ - std::chrono::steady_clock::now());
+          timeout_ms = static_cast<int>(std::max(remaining.count() + 1, static_cast<int64_t>(0)));
+        }
+      }
+      const int n = ::epoll_wait(epoll_fd_, events.data(), kMaxEventsPerWait, timeout_ms);
+      for (int i = 0; i < n; ++i) {
+        if (events[i].data.u64 == kWakeupID) {
+          uint64_t unused;
+          static_cast<void>(::read(wakeup_fd_, &unused, sizeof(unused)));
+          ProcessScheduledCloses();
+        } else {
+          OnEvent(events[i].data.u64, events[i].events);
+        }
+      }
+      ExpireTimers();
+    }
+  }
+
+  void OnEvent(uint64_t id, uint32_t events) {
+    Parked parked;
+    std::shared_ptr<ReactorConnection> adopted;
+    std::shared_ptr<Watched> watched;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      const auto cit = parked_.find(id);
+      const auto wit = watched_.find(id);
+      if (wit != watched_.end()) {
+        watched = wit->second;
+      } else if (cit != parked_.end()) {
+        parked = std::move(cit->second);
+        parked_.erase(cit);
+        deadlines_.erase(std::make_pair(parked.deadline, id));
+        RemoveFromEpoll(parked.connection->socket);
+      } else {
+        const auto cit = adopted_.find(id);
+        if (cit != adopted_.end()) {
+          adopted = cit->second;
+        }
+      }
+    }
+    if (watched) {
+      watched->on_event(id, events);
+    } else if (parked.connection) {
+      parked.on_readable(std::move(parked.connection));
+    } else if (adopted) {
+      bool done = (events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) || ((events & EPOLLIN) && !adopted->DiscardInput());
+      if (!done && (events & EPOLLOUT)) {
+        std::lock_guard<std::mutex> lock(adopted->mutex_);
+        done = !adopted->Flush() || (adopted->closing_ && adopted->output_.empty());
+      }
+      if (done) {
+        Finalize(id);
+      }
+    }
+  }
+
+  void ProcessScheduledCloses() {
+    std::vector<uint64_t> ids;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ids.swap(closing_);
+    }
+    for (uint64_t id : ids) {
+      std::shared_ptr<ReactorConnection> adopted;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto cit = adopted_.find(id);
+        if (cit != adopted_.end()) {
+          adopted = cit->second;
+        }
+      }
+      if (adopted) {
+        bool drained;
+        {
+          std::lock_guard<std::mutex> lock(adopted->mutex_);
+          drained = adopted->broken_ || adopted->output_offset_ == adopted->output_.length();
+        }
+        // The connection with data still queued is closed once `EPOLLOUT` has flushed it.
+        if (drained) {
+          Finalize(id);
+        }
+      }
+    }
+  }
+
+  void ExpireTimers() {
+    const auto now = std::chrono::steady_clock::now();
+    std::vector<std::unique_ptr<Connection>> timed_out;
+    std::vector<std::shared_ptr<ReactorConnection>> to_check;
+    std::vector<std::shared_ptr<Watched>> watched_timed_out;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      while (!deadlines_.empty() && deadlines_.begin()->first <= now) {
+        const uint64_t id = deadlines_.begin()->second;
+        deadlines_.erase(deadlines_.begin());
+        const auto cit = parked_.find(id);
+        const auto wit = watched_.find(id);
+        if (wit != watched_.end()) {
+          RemoveFromEpoll(wit->second->fd);
+          watched_timed_out.push_back(std::move(wit->second));
+          watched_.erase(wit);
+        } else if (cit != parked_.end()) {
+          RemoveFromEpoll(cit->second.connection->socket);
+          timed_out.push_back(std::move(cit->second.connection));
+          parked_.erase(cit);
+        } else {
+          const auto cit = adopted_.find(id);
+          if (cit != adopted_.end()) {
+            to_check.push_back(cit->second);
+          }
+        }
+      }
+    }
+    for (const auto& watched : watched_timed_out) {
+      watched->on_timeout();
+    }
+    // The timers of the adopted connections are pushed back lazily, as the connections are written to.
+    for (const auto& adopted : to_check) {
+      time_point_t deadline;
+      {
+        std::lock_guard<std::mutex> lock(adopted->mutex_);
+        deadline = adopted->last_write_ + adopted->idle_timeout_;
+      }
+      if (deadline <= now) {
+        Finalize(adopted->id_);
+      } else {
+        std::lock_guard<std::mutex> lock(mutex_);
+        adopted->deadline_ = deadline;
+        deadlines_.emplace(deadline, adopted->id_);
+      }
+    }
+  }
+
+  void Finalize(uint64_t id) {
+    std::shared_ptr<ReactorConnection> adopted;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      const auto cit = adopted_.find(id);
+      if (cit == adopted_.end()) {
+        return;
+      }
+      adopted = std::move(cit->second);
+      adopted_.erase(cit);
+      deadlines_.erase(std::make_pair(adopted->deadline_, id));
+      RemoveFromEpoll(adopted->fd_);
+    }
+    std::function<void()> on_closed;
+    {
+      std::lock_guard<std::mutex> lock(adopted->mutex_);
+      adopted->closed_ = true;
+      adopted->connection_ = nullptr;
+      std::string().swap(adopted->output_);
+      adopted->output_offset_ = 0u;
+      on_closed = std::move(adopted->on_closed_);
+    }
+    if (on_closed) {
+      on_closed();
+    }
+  }
+
+  const int epoll_fd_;
+  const int wakeup_fd_;
+  std::atomic_bool terminating_{false};
+
+  mutable std::mutex mutex_;
+  uint64_t last_id_ = kWakeupID;
+  std::map<uint64_t, Parked> parked_;
+  std::map<uint64_t, std::shared_ptr<ReactorConnection>> adopted_;
+  std::map<uint64_t, std::shared_ptr<Watched>> watched_;
+  std::set<std::pair<time_point_t, uint64_t>> deadlines_;
+  std::vector<uint64_t> closing_;
+  // The earliest timer as of the reactor going to sleep, for the new connections to only wake it up if need be.
+  time_point_t sleeping_until_ = time_point_t::max();
+
+  std::thread thread_;
+
+  Reactor(const Reactor&) = delete;
+  void operator=(const Reactor&) = delete;
+};
+
+inline void ReactorConnection::Close() {
+  Reactor* reactor;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closing_ || closed_) {
+      return;
+    }
+    closing_ = true;
+    reactor = reactor_;
+  }
+  if (reactor) {
+    reactor->ScheduleClose(id_);
+  }
+}
+
+// Starts connecting to `address` without blocking. Once the connection is established, or has failed, the socket
+// becomes writable, and `SO_ERROR` tells which one it is. The socket is left non-blocking, see `SetBlocking()`.
+inline std::unique_ptr<Connection> ConnectWithoutBlocking(const sockaddr_in& address) {
+  SocketHandle handle(SocketHandle::DoNotBind{});
+  const SOCKET fd = handle.socket;
+  SetBlocking(fd, false);
+  if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) && errno != EINPROGRESS) {
+    CURRENT_THROW(SocketConnectException());  // LCOV_EXCL_LINE
+  }
+  sockaddr_in local;
+  socklen_t local_length = sizeof(local);
+  if (::getsockname(fd, reinterpret_cast<sockaddr*>(&local), &local_length)) {
+    CURRENT_THROW(SocketGetSockNameException());  // LCOV_EXCL_LINE
+  }
+  return std::make_unique<Connection>(std::move(handle),
+                                      IPAndPort(InetAddrToString(&local.sin_addr), ntohs(local.sin_port)),
+                                      IPAndPort(InetAddrToString(&address.sin_addr), ntohs(address.sin_port)));
+}
+
+// The reactor shared by the users that do not need one of their own, such as the chunked HTTP responses.
+inline Reactor& DefaultReactor() { return Singleton<Reactor>(); }
+
+}  // namespace net
+}  // namespace current
+
+#endif  // CURRENT_POSIX
+
+#endif  // BRICKS_NET_TCP_IMPL_REACTOR_H
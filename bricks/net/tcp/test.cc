@@ -377,3 +377,102 @@ TEST(TCPTest, PickLocalPortWithHint) {
   EXPECT_NE(static_cast<uint16_t>(p3), i1);
   EXPECT_NE(static_cast<uint16_t>(p3), i2);
 }
+
+#ifdef CURRENT_POSIX
+
+TEST(TCPTest, ReactorParksIdleConnections) {
+  auto port_reservation = ReserveLocalPort();
+  const uint16_t port = port_reservation;
+  Socket socket(std::move(port_reservation));
+
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Connection>> readable;
+  std::vector<std::unique_ptr<Connection>> clients;
+  // Declared after what its callbacks use, so that it is stopped first.
+  current::net::Reactor reactor;
+  for (size_t i = 0u; i < 100u; ++i) {
+    clients.push_back(std::make_unique<Connection>(ClientSocket("localhost", port)));
+    reactor.Park(std::make_unique<Connection>(socket.Accept()),
+                 std::chrono::minutes(1),
+                 [&mutex, &readable](std::unique_ptr<Connection> connection) {
+                   std::lock_guard<std::mutex> lock(mutex);
+                   readable.push_back(std::move(connection));
+                 });
+  }
+  EXPECT_EQ(100u, reactor.ParkedConnections());
+
+  // The connection the client has sent something over is handed back, to be read from and written to as usual.
+  clients[42]->BlockingWrite("ping", false);
+  while (reactor.ParkedConnections() != 99u) {
+    std::this_thread::yield();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(1u, readable.size());
+    char buffer[5] = {0};
+    ASSERT_EQ(4u, readable.front()->BlockingRead(buffer, 4u, Connection::BlockingReadPolicy::FillFullBuffer));
+    EXPECT_EQ("ping", std::string(buffer));
+    readable.front()->BlockingWrite("pong", false);
+  }
+  {
+    char buffer[5] = {0};
+    ASSERT_EQ(4u, clients[42]->BlockingRead(buffer, 4u, Connection::BlockingReadPolicy::FillFullBuffer));
+    EXPECT_EQ("pong", std::string(buffer));
+  }
+
+  // The connection that stays idle for longer than its timeout is closed.
+  clients.push_back(std::make_unique<Connection>(ClientSocket("localhost", port)));
+  reactor.Park(std::make_unique<Connection>(socket.Accept()),
+               std::chrono::milliseconds(10),
+               [](std::unique_ptr<Connection>) { ASSERT_TRUE(false); });
+  char buffer[1];
+  ASSERT_THROW(clients.back()->BlockingRead(buffer, 1u), SocketException);
+  EXPECT_EQ(99u, reactor.ParkedConnections());
+}
+
+TEST(TCPTest, ReactorWritesWithoutBlocking) {
+  auto port_reservation = ReserveLocalPort();
+  const uint16_t port = port_reservation;
+  Socket socket(std::move(port_reservation));
+
+  // Far more data than the socket takes at once is queued right away, and sent as the client reads it.
+  Connection client(ClientSocket("localhost", port));
+  std::atomic_bool closed(false);
+  current::net::Reactor reactor;
+  const auto connection =
+      reactor.Adopt(std::make_unique<Connection>(socket.Accept()), [&closed]() { closed = true; });
+  EXPECT_EQ(1u, reactor.AdoptedConnections());
+  std::string data(1u << 23, '.');
+  for (size_t i = 0u; i < data.length(); i += 1000u) {
+    data[i] = static_cast<char>('a' + (i / 1000u) % 26u);
+  }
+  EXPECT_TRUE(connection->Write(data));
+  EXPECT_GT(connection->BufferedBytes(), 0u);
+  connection->Close();
+  EXPECT_FALSE(connection->Write("too late"));
+  std::string received(data.length(), ' ');
+  ASSERT_EQ(data.length(),
+            client.BlockingRead(&received[0], data.length(), Connection::BlockingReadPolicy::FillFullBuffer));
+  EXPECT_TRUE(received == data);
+  char buffer[1];
+  ASSERT_THROW(client.BlockingRead(buffer, 1u), SocketException);
+  while (!closed) {
+    std::this_thread::yield();
+  }
+  EXPECT_TRUE(connection->Closed());
+  EXPECT_EQ(0u, reactor.AdoptedConnections());
+
+  // The client going away closes the adopted connection.
+  auto gone = std::make_unique<Connection>(ClientSocket("localhost", port));
+  closed = false;
+  const auto orphaned =
+      reactor.Adopt(std::make_unique<Connection>(socket.Accept()), [&closed]() { closed = true; });
+  gone = nullptr;
+  while (!closed) {
+    std::this_thread::yield();
+  }
+  EXPECT_TRUE(orphaned->Closed());
+  EXPECT_FALSE(orphaned->Write("nobody is listening"));
+}
+
+#endif  // CURRENT_POSIX
@@ -27,7 +27,10 @@ SOFTWARE.
 
 #include "../../port.h"
 
+#include <atomic>
 #include <mutex>
+#include <shared_mutex>
+#include <thread>
 #include <type_traits>
 
 namespace current {
@@ -46,6 +49,42 @@ using SmartMutexLockGuard = std::conditional_t<MLS == MutexLockStatus::NeedToLoc
 static_assert(std::is_same_v<std::lock_guard<std::mutex>, SmartMutexLockGuard<MutexLockStatus::NeedToLock>>, "");
 static_assert(std::is_same_v<NoOpLock, SmartMutexLockGuard<MutexLockStatus::AlreadyLocked>>, "");
 
+// The `std::shared_mutex` that does not let a steady flow of readers starve the writers: once a writer is waiting,
+// the new readers step aside until it is done. The readers already holding the lock are not affected.
+class WriterPreferringSharedMutex final {
+ public:
+  void lock() {
+    ++writers_waiting_;
+    mutex_.lock();
+    --writers_waiting_;
+  }
+  bool try_lock() { return mutex_.try_lock(); }
+  void unlock() { mutex_.unlock(); }
+
+  void lock_shared() {
+    while (writers_waiting_) {
+      std::this_thread::yield();
+    }
+    mutex_.lock_shared();
+  }
+  bool try_lock_shared() { return !writers_waiting_ && mutex_.try_lock_shared(); }
+  void unlock_shared() { mutex_.unlock_shared(); }
+
+ private:
+  std::atomic_size_t writers_waiting_{0u};
+  std::shared_mutex mutex_;
+};
+
+// The shared, reader-side, counterpart of `SmartMutexLockGuard`.
+template <MutexLockStatus MLS, class MUTEX = std::shared_mutex>
+using SmartSharedMutexLockGuard =
+    std::conditional_t<MLS == MutexLockStatus::NeedToLock, std::shared_lock<MUTEX>, NoOpLock>;
+
+static_assert(std::is_same_v<std::shared_lock<std::shared_mutex>,
+                             SmartSharedMutexLockGuard<MutexLockStatus::NeedToLock>>,
+              "");
+static_assert(std::is_same_v<NoOpLock, SmartSharedMutexLockGuard<MutexLockStatus::AlreadyLocked>>, "");
+
 }  // namespace locks
 }  // namespace current
 
@@ -27,6 +27,7 @@ SOFTWARE.
 
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
 #include <unordered_set>
 
@@ -102,12 +103,16 @@ class WaitableTerminateSignalBulkNotifier {
 
   // THREAD-SAFE.
   void NotifyAllOfExternalWaitableEvent() {
+    events_.fetch_add(1u, std::memory_order_release);
     std::lock_guard<std::mutex> lock(mutex_);
     for (WaitableTerminateSignal* signal : active_signals_) {
       signal->NotifyOfExternalWaitableEvent();
     }
   }
 
+  // The number of the events notified of so far, to spin on without locking anything. THREAD-SAFE.
+  uint64_t Events() const { return events_.load(std::memory_order_acquire); }
+
   // THREAD-SAFE.
   void RegisterPendingNotifier(WaitableTerminateSignal& signal) {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -124,6 +129,7 @@ class WaitableTerminateSignalBulkNotifier {
   // Can't use `reference_wrapper` w/o a global `operator<()` -- a member one doesn't nail it. -- D.K.
   std::mutex mutex_;
   std::unordered_set<WaitableTerminateSignal*> active_signals_;
+  std::atomic<uint64_t> events_{0u};
 };
 
 }  // namespace current
@@ -39,52 +39,83 @@ DEFINE_int32(threads,
              "measurement will be imprecise if (ping) / (time to service the request) is greater than "
              "FLAGS_threads. Thus, this benchmarking tool is not useful when profiling remote servers.");
 
+DEFINE_uint32(server_threads, 1, "The number of threads serving the port, see `HTTPServerPOSIX::SetThreads()`.");
+DEFINE_bool(reuseport, false, "Give each extra serving thread its own `SO_REUSEPORT` listening socket.");
+DEFINE_int32(slow_threads, 0, "The number of extra threads to keep calling the slow route, `/sleep`, from.");
+DEFINE_int32(slow_ms, 50, "The number of milliseconds each call to the slow route takes.");
+
 int main(int argc, char** argv) {
   ParseDFlags(&argc, &argv);
 
   class Worker {
    public:
-    Worker(int port, double seconds) : seconds_(seconds), queries_(0u), thread_(&Worker::Thread, this, port) {}
+    Worker(int port, double seconds, int slow_ms)
+        : seconds_(seconds), slow_ms_(slow_ms), thread_(&Worker::Thread, this, port) {}
     void Join() { thread_.join(); }
-    size_t TotalQueries() const { return queries_; }
+    const std::vector<std::chrono::microseconds>& Latencies() const { return latencies_; }
 
    private:
     static double NowInSeconds() { return 1e-6 * static_cast<double>(time::Now().count()); }
     void Thread(int port) {
       const double timestamp_end = NowInSeconds() + seconds_;
       while (NowInSeconds() < timestamp_end) {
-        const int a = current::random::RandomIntegral(-1000000, +1000000);
-        const int b = current::random::RandomIntegral(-1000000, +1000000);
-        const auto r = HTTP(GET(strings::Printf(FLAGS_url.c_str(), port) + strings::Printf("?a=%d&b=%d", a, b)));
-        CURRENT_ASSERT(r.code == HTTPResponseCode.OK);
-        CURRENT_ASSERT(ParseJSON<AddResult>(r.body).sum == a + b);
-        ++queries_;
+        const std::chrono::microseconds begin = time::Now();
+        if (slow_ms_) {
+          const auto r = HTTP(GET(strings::Printf("http://localhost:%d/sleep?ms=%d", port, slow_ms_)));
+          CURRENT_ASSERT(r.code == HTTPResponseCode.OK);
+        } else {
+          const int a = current::random::RandomIntegral(-1000000, +1000000);
+          const int b = current::random::RandomIntegral(-1000000, +1000000);
+          const auto r = HTTP(GET(strings::Printf(FLAGS_url.c_str(), port) + strings::Printf("?a=%d&b=%d", a, b)));
+          CURRENT_ASSERT(r.code == HTTPResponseCode.OK);
+          CURRENT_ASSERT(ParseJSON<AddResult>(r.body).sum == a + b);
+        }
+        latencies_.push_back(time::Now() - begin);
       }
     }
 
     const double seconds_;
-    size_t queries_;
+    const int slow_ms_;
+    std::vector<std::chrono::microseconds> latencies_;
     std::thread thread_;
   };
 
   auto reserved_port = current::net::ReserveLocalPort();
   const int port = reserved_port;
-  auto& http_server = HTTP(std::move(reserved_port));
-  static_cast<void>(http_server);
-
+  BenchmarkTestServer server(std::move(reserved_port), "/add");
+  server.SetThreads(FLAGS_server_threads,
+                    FLAGS_reuseport ? current::http::HTTPServerListeners::ReusePort
+                                    : current::http::HTTPServerListeners::Shared);
+
+  std::vector<std::unique_ptr<Worker>> slow_threads(FLAGS_slow_threads);
+  for (auto& t : slow_threads) {
+    t = std::make_unique<Worker>(port, FLAGS_seconds, FLAGS_slow_ms);
+  }
   std::vector<std::unique_ptr<Worker>> threads(FLAGS_threads);
   for (auto& t : threads) {
-    t = std::make_unique<Worker>(port, FLAGS_seconds);
+    t = std::make_unique<Worker>(port, FLAGS_seconds, 0);
   }
 
   for (auto& t : threads) {
     t->Join();
   }
+  for (auto& t : slow_threads) {
+    t->Join();
+  }
 
-  size_t total_queries = 0u;
+  // Only the latencies of the fast route are reported, the slow one is there to get in its way.
+  std::vector<std::chrono::microseconds> latencies;
   for (auto& t : threads) {
-    total_queries += t->TotalQueries();
+    latencies.insert(latencies.end(), t->Latencies().begin(), t->Latencies().end());
   }
+  std::sort(latencies.begin(), latencies.end());
+  const auto percentile = [&latencies](double p) {
+    return latencies.empty() ? 0.0
+                             : 1e-3 * latencies[std::min(static_cast<size_t>(p * latencies.size()),
+                                                         latencies.size() - 1u)].count();
+  };
 
-  std::cout << "QPS: " << std::setw(3) << (total_queries / FLAGS_seconds) << std::endl;
+  std::cout << "QPS: " << std::setw(3) << (latencies.size() / FLAGS_seconds) << std::endl;
+  std::cout << "Latency, ms: p50 " << percentile(0.5) << ", p90 " << percentile(0.9) << ", p99 " << percentile(0.99)
+            << ", max " << percentile(1.0) << std::endl;
 }
@@ -39,7 +39,17 @@ class BenchmarkTestServer {
         http_server_(HTTP(std::move(reserved_port))),
         scope_(http_server_.Register(route, [](Request r) {
           r(AddResult(current::FromString<int64_t>(r.url.query["a"]) + current::FromString<int64_t>(r.url.query["b"])));
-        }) + http_server_.Register("/perftest", [](Request r) { r("perftest ok\n"); })) {}
+        }) + http_server_.Register("/perftest", [](Request r) { r("perftest ok\n"); }) +
+               http_server_.Register("/sleep", [](Request r) {
+                 // The slow route, to see how it holds back the other requests to the same port.
+                 std::this_thread::sleep_for(std::chrono::milliseconds(current::FromString<int>(r.url.query["ms"])));
+                 r("slept\n");
+               })) {}
+
+  BenchmarkTestServer& SetThreads(size_t threads, current::http::HTTPServerListeners listeners) {
+    http_server_.SetThreads(threads, listeners);
+    return *this;
+  }
 
   void Join() { http_server_.Join(); }
 
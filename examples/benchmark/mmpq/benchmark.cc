@@ -0,0 +1,146 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2026 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+
+// Compares the `RadixHeap` now backing MMPQ with the ordered set it has replaced, as well as runs MMPQ end to end.
+//
+// The "dense" schedule is many messages a few microseconds into the future, the "sparse" one is messages spread
+// across hours into the future, and the "mixed" one has 90% dense and 10% sparse messages.
+
+#include <set>
+
+#include "../../../blocks/mmq/mmpq.h"
+#include "../../../blocks/mmq/radix_heap.h"
+
+#include "../../../bricks/dflags/dflags.h"
+#include "../../../bricks/util/random.h"
+
+DEFINE_uint32(n, 1000000, "The number of messages to schedule.");
+DEFINE_uint32(pending, 10000, "The number of messages pending in the queue at any given time.");
+DEFINE_uint32(dense_us, 100, "The \"dense\" messages are scheduled up to this many microseconds into the future.");
+DEFINE_uint64(sparse_us, 3600ull * 1000 * 1000, "The \"sparse\" messages are scheduled up to this far away.");
+
+struct Message {
+  uint64_t payload[4];
+};
+
+// The way MMPQ used to keep the messages: a node-based ordered set.
+struct OrderedSetQueue {
+  struct Entry {
+    uint64_t key;
+    uint64_t sequence;
+    Message message;
+    bool operator<(const Entry& rhs) const { return key < rhs.key || (key == rhs.key && sequence < rhs.sequence); }
+  };
+  std::set<Entry> set;
+  void Push(uint64_t key, uint64_t sequence, const Message& message) { set.insert(Entry{key, sequence, message}); }
+  uint64_t TopKey() const { return set.begin()->key; }
+  void Pop() { set.erase(set.begin()); }
+};
+
+struct RadixHeapQueue {
+  current::mmq::RadixHeap<Message> heap;
+  void Push(uint64_t key, uint64_t sequence, const Message& message) { heap.Push(key, sequence, message); }
+  uint64_t TopKey() { return heap.TopKey(); }
+  void Pop() { heap.Pop(); }
+};
+
+std::vector<uint64_t> GenerateDelays(int dense_percentage) {
+  std::vector<uint64_t> delays(FLAGS_n);
+  for (auto& delay : delays) {
+    if (current::random::RandomIntegral<int>(0, 99) < dense_percentage) {
+      delay = current::random::RandomIntegral<uint64_t>(1u, FLAGS_dense_us);
+    } else {
+      delay = current::random::RandomIntegral<uint64_t>(1u, FLAGS_sparse_us);
+    }
+  }
+  return delays;
+}
+
+// Keeps `--pending` messages in the queue, each time extracting the earliest one and scheduling a new one.
+template <typename QUEUE>
+double RunQueue(const std::vector<uint64_t>& delays) {
+  QUEUE queue;
+  const auto start = std::chrono::steady_clock::now();
+  uint64_t now = 0u;
+  uint64_t checksum = 0u;
+  for (uint64_t i = 0u; i < delays.size(); ++i) {
+    if (i >= FLAGS_pending) {
+      now = queue.TopKey();
+      checksum += now;
+      queue.Pop();
+    }
+    queue.Push(now + delays[i], i, Message{{i, i, i, i}});
+  }
+  const auto end = std::chrono::steady_clock::now();
+  if (!checksum) {
+    std::cerr << "Unexpected." << std::endl;
+  }
+  return 1e-3 * std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+}
+
+// Publishes `--n` messages into MMPQ at the timestamps ahead of the head, moving the head forward as it goes.
+double RunMMPQ(const std::vector<uint64_t>& delays) {
+  struct ConsumerImpl {
+    std::atomic_size_t processed;
+    ConsumerImpl() : processed(0u) {}
+    current::ss::EntryResponse operator()(const Message&, idxts_t, idxts_t) {
+      ++processed;
+      return current::ss::EntryResponse::More;
+    }
+  };
+  using consumer_t = current::ss::EntrySubscriber<ConsumerImpl, Message>;
+
+  consumer_t consumer;
+  const auto start = std::chrono::steady_clock::now();
+  {
+    current::mmq::MMPQ<Message, consumer_t> mmpq(consumer);
+    const uint64_t base = 1000000u;
+    for (uint64_t i = 0u; i < delays.size(); ++i) {
+      mmpq.Publish(Message{{i, i, i, i}}, std::chrono::microseconds(base + i + delays[i]));
+      if (!(i % 1000u)) {
+        mmpq.UpdateHead(std::chrono::microseconds(base + i + 1u));
+      }
+    }
+    mmpq.UpdateHead(std::chrono::microseconds(base + delays.size() + FLAGS_sparse_us + 1u));
+    while (consumer.processed != delays.size()) {
+      std::this_thread::yield();
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+  return 1e-3 * std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+}
+
+int main(int argc, char** argv) {
+  ParseDFlags(&argc, &argv);
+
+  for (const auto& schedule : std::vector<std::pair<std::string, int>>{{"dense", 100}, {"sparse", 0}, {"mixed", 90}}) {
+    const std::vector<uint64_t> delays = GenerateDelays(schedule.second);
+    std::cout << schedule.first << ", " << FLAGS_n << " messages, " << FLAGS_pending << " pending:" << std::endl;
+    std::cout << "  std::set\t" << RunQueue<OrderedSetQueue>(delays) << " ms" << std::endl;
+    std::cout << "  RadixHeap\t" << RunQueue<RadixHeapQueue>(delays) << " ms" << std::endl;
+    std::cout << "  MMPQ\t\t" << RunMMPQ(delays) << " ms" << std::endl;
+  }
+  return 0;
+}